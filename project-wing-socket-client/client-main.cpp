@@ -8,64 +8,18 @@
 #include <queue>
 #include <mutex>
 #include <memory>
+#include <array>
+#include <atomic>
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #pragma comment(lib, "ws2_32.lib")
 
+// 서버와 같은 메시지 목록과 바디 규칙.
+#include "Network/MessageSchema.h"
+
 #define PORT 12345
 #define SERVER_IP "127.0.0.1"
 
-namespace ClientMessage
-{
-	enum Type
-	{
-		MSG_HEARTBEAT,
-		MSG_START,
-		MSG_PICK_CHARACTER,
-		MSG_PICK_ITEM,
-		MSG_PICK_MAP,
-		MSG_READY,
-		MSG_UNREADY,
-		MSG_MOVE_UP,
-		MSG_MOVE_DOWN,
-		MSG_PLAYER_DEAD
-	};
-}
-
-namespace ServerMessage
-{
-	enum Type
-	{
-		MSG_CONNECTED,
-		MSG_NEW_OWNER,
-		MSG_HEARTBEAT_ACK,
-		MSG_START_ACK,
-		MSG_JOIN,
-		MSG_DISCONNECT, // 이건 누가 나간거.
-		MSG_CONNECTED_REJECT,
-		MSG_ROOM_FULL_INFO,
-		MSG_PICK_CHARACTER,
-		MSG_PICK_ITEM,
-		MSG_PICK_MAP,
-		MSG_READY,
-		MSG_UNREADY,
-		MSG_MOVE_UP,
-		MSG_MOVE_DOWN,
-		MSG_PLAYER_DEAD,
-		MSG_GAME_OVER,
-		MSG_END // 내가 끊긴거
-	};
-}
-
-#pragma pack(push, 1)
-struct MessageHeader
-{
-	int senderId;
-	int msgType;
-	int bodyLen;
-};
-#pragma pack(pop)
-
 struct RecvMessage
 {
 	int senderId;
@@ -116,6 +70,20 @@ public:
 		if (body && bodyLen > 0) SendAll(mSock, (char*)body, bodyLen);
 	}
 
+	// 바디 없는 메시지. 스키마에 바디 없이 보내도 된다고 되어 있어야 함.
+	template<typename Schema>
+	void Send()
+	{
+		static_assert(Schema::Rule().layout == EBodyLayout::Empty || Schema::Rule().altSize == 0, "message needs a body");
+		SendMsg(0, (int)Schema::Type, nullptr, 0);
+	}
+
+	template<typename Schema>
+	void Send(const typename Schema::Body& body)
+	{
+		SendMsg(0, (int)Schema::Type, &body, sizeof(body));
+	}
+
 	bool PollMessage(RecvMessage& out)
 	{
 		std::lock_guard<std::mutex> lock(mQueueMutex);
@@ -147,7 +115,7 @@ private:
 		while (true)
 		{
 			std::this_thread::sleep_for(std::chrono::seconds(1));
-			SendMsg(0, (int)ClientMessage::MSG_HEARTBEAT, nullptr, 0);
+			Send<TClientSchema<ClientMessage::MSG_HEARTBEAT>>();
 		}
 	}
 
@@ -185,11 +153,161 @@ private:
 	}
 };
 
+// 마지막으로 받은 스냅샷 틱. 충돌 신고에 붙여 보냄.
+std::atomic<int> gLastSnapshotTick{ 0 };
+
+// 서버 메시지 처리. 바디 길이는 부르기 전에 스키마로 확인했음.
+typedef void(*FServerHandler)(const RecvMessage& msg);
+
+static const char* GetBody(const RecvMessage& msg) { return msg.body.data(); }
+static int GetBodyLen(const RecvMessage& msg) { return (int)msg.body.size(); }
+
+static void OnConnected(const RecvMessage& msg)
+{
+	int myId;
+	DecodeBody<TServerSchema<ServerMessage::MSG_CONNECTED>>(GetBody(msg), GetBodyLen(msg), myId);
+	std::cout << "[System] Connected. My ID: " << myId << "\n";
+}
+
+static void OnNewOwner(const RecvMessage& msg)
+{
+	int newOwnerId;
+	DecodeBody<TServerSchema<ServerMessage::MSG_NEW_OWNER>>(GetBody(msg), GetBodyLen(msg), newOwnerId);
+	std::cout << "[System] New Room Owner is: " << newOwnerId << "\n";
+}
+
+static void OnConnectedReject(const RecvMessage& msg)
+{
+	std::cout << "[System] Connection rejected: " << GetBody(msg) << "\n";
+	exit(0);
+}
+
+static void OnJoin(const RecvMessage& msg)
+{
+	int id;
+	DecodeBody<TServerSchema<ServerMessage::MSG_JOIN>>(GetBody(msg), GetBodyLen(msg), id);
+	std::cout << "[System] Player joined: " << id << "\n";
+}
+
+static void OnDisconnect(const RecvMessage& msg)
+{
+	int id;
+	DecodeBody<TServerSchema<ServerMessage::MSG_DISCONNECT>>(GetBody(msg), GetBodyLen(msg), id);
+	std::cout << "[System] Player disconnected: " << id << "\n";
+}
+
+static void OnGameOver(const RecvMessage& msg)
+{
+	std::cout << "[Game Over] " << GetBody(msg) << "\n";
+}
+
+static void OnMoveUp(const RecvMessage& msg)
+{
+	std::cout << "[Game] Player " << msg.senderId << " moved UP\n";
+}
+
+static void OnMoveDown(const RecvMessage& msg)
+{
+	std::cout << "[Game] Player " << msg.senderId << " moved DOWN\n";
+}
+
+static void OnPlayerDead(const RecvMessage& msg)
+{
+	std::cout << "[Game] Player " << msg.senderId << " is DEAD\n";
+}
+
+static void OnRoomFullInfo(const RecvMessage& msg)
+{
+	typedef TServerSchema<ServerMessage::MSG_ROOM_FULL_INFO> Schema;
+
+	RoomFullInfoHeader info = DecodeArrayHeader<Schema>(GetBody(msg));
+	std::cout << "[ROOM_INFO] Owner: " << info.ownerId << ", Map: " << info.mapId << ", Players: " << info.playerCount << "\n";
+
+	for (int i = 0; i < info.playerCount; ++i)
+	{
+		RoomPlayerInfo player = DecodeArrayElem<Schema>(GetBody(msg), i);
+		std::cout << "  Player " << player.id << " - Ready: " << (player.isReady ? "Yes" : "No")
+			<< ", Character: " << player.characterId
+			<< ", Items: [" << player.itemSlots[0] << ", " << player.itemSlots[1] << ", " << player.itemSlots[2] << "]\n";
+	}
+}
+
+static void OnStartAck(const RecvMessage& msg)
+{
+	// readyFlag + 장애물 코스 시드.
+	StartAck ack;
+	DecodeBody<TServerSchema<ServerMessage::MSG_START_ACK>>(GetBody(msg), GetBodyLen(msg), ack);
+	std::cout << "[Game] Game Started: " << ack.readyFlag << ", course seed: " << ack.courseSeed << "\n";
+}
+
+static void OnReady(const RecvMessage& msg)
+{
+	std::cout << "[Game] Player " << msg.senderId << " is READY\n";
+}
+
+static void OnUnready(const RecvMessage& msg)
+{
+	std::cout << "[Game] Player " << msg.senderId << " is UNREADY\n";
+}
+
+static void OnPickMap(const RecvMessage& msg)
+{
+	int mapId;
+	DecodeBody<TServerSchema<ServerMessage::MSG_PICK_MAP>>(GetBody(msg), GetBodyLen(msg), mapId);
+	std::cout << "[Game] Player " << msg.senderId << " selected Map ID: " << mapId << "\n";
+}
+
+static void OnPickCharacter(const RecvMessage& msg)
+{
+	int charId;
+	DecodeBody<TServerSchema<ServerMessage::MSG_PICK_CHARACTER>>(GetBody(msg), GetBodyLen(msg), charId);
+	std::cout << "[Game] Player " << msg.senderId << " picked Character: " << charId << "\n";
+}
+
+static void OnPickItem(const RecvMessage& msg)
+{
+	PickItem pick;
+	DecodeBody<TServerSchema<ServerMessage::MSG_PICK_ITEM>>(GetBody(msg), GetBodyLen(msg), pick);
+	std::cout << "[Game] Player " << msg.senderId << " equipped item " << pick.itemId << " in slot " << pick.slot << "\n";
+}
+
+static void OnWorldSnapshot(const RecvMessage& msg)
+{
+	WorldSnapshotHeader header = DecodeArrayHeader<TServerSchema<ServerMessage::MSG_WORLD_SNAPSHOT>>(GetBody(msg));
+	gLastSnapshotTick = header.tick;
+}
+
+// 메시지 번호로 바로 찾음. 없는 칸은 로그만 남김.
+static std::array<FServerHandler, ServerMessage::MSG_END> MakeServerHandlers()
+{
+	std::array<FServerHandler, ServerMessage::MSG_END> handlers{};
+	handlers[ServerMessage::MSG_CONNECTED] = OnConnected;
+	handlers[ServerMessage::MSG_NEW_OWNER] = OnNewOwner;
+	handlers[ServerMessage::MSG_CONNECTED_REJECT] = OnConnectedReject;
+	handlers[ServerMessage::MSG_JOIN] = OnJoin;
+	handlers[ServerMessage::MSG_DISCONNECT] = OnDisconnect;
+	handlers[ServerMessage::MSG_GAME_OVER] = OnGameOver;
+	handlers[ServerMessage::MSG_MOVE_UP] = OnMoveUp;
+	handlers[ServerMessage::MSG_MOVE_DOWN] = OnMoveDown;
+	handlers[ServerMessage::MSG_PLAYER_DEAD] = OnPlayerDead;
+	handlers[ServerMessage::MSG_ROOM_FULL_INFO] = OnRoomFullInfo;
+	handlers[ServerMessage::MSG_START_ACK] = OnStartAck;
+	handlers[ServerMessage::MSG_READY] = OnReady;
+	handlers[ServerMessage::MSG_UNREADY] = OnUnready;
+	handlers[ServerMessage::MSG_PICK_MAP] = OnPickMap;
+	handlers[ServerMessage::MSG_PICK_CHARACTER] = OnPickCharacter;
+	handlers[ServerMessage::MSG_PICK_ITEM] = OnPickItem;
+	handlers[ServerMessage::MSG_WORLD_SNAPSHOT] = OnWorldSnapshot;
+	return handlers;
+}
+
 int main()
 {
 	CClient client;
 	if (!client.Init()) return -1;
 
+	const std::array<FServerHandler, ServerMessage::MSG_END> handlers = MakeServerHandlers();
+
 	std::thread inputThread([&]()
 		{
 			while (true)
@@ -198,33 +316,36 @@ int main()
 				std::getline(std::cin, input);
 
 				if (input == "start")
-					client.SendMsg(0, (int)ClientMessage::MSG_START, nullptr, 0);
+					client.Send<TClientSchema<ClientMessage::MSG_START>>();
 				else if (input == "ready")
-					client.SendMsg(0, (int)ClientMessage::MSG_READY, nullptr, 0);
+					client.Send<TClientSchema<ClientMessage::MSG_READY>>();
 				else if (input == "unready")
-					client.SendMsg(0, (int)ClientMessage::MSG_UNREADY, nullptr, 0);
+					client.Send<TClientSchema<ClientMessage::MSG_UNREADY>>();
 				else if (input == "up")
-					client.SendMsg(0, (int)ClientMessage::MSG_MOVE_UP, nullptr, 0);
+					client.Send<TClientSchema<ClientMessage::MSG_MOVE_UP>>();
 				else if (input == "down")
-					client.SendMsg(0, (int)ClientMessage::MSG_MOVE_DOWN, nullptr, 0);
-				else if (input == "dead")
-					client.SendMsg(0, (int)ClientMessage::MSG_PLAYER_DEAD, nullptr, 0);
+					client.Send<TClientSchema<ClientMessage::MSG_MOVE_DOWN>>();
+				else if (input.rfind("hit ", 0) == 0)
+				{
+					// 박은 장애물 칸. 틱은 마지막으로 받은 스냅샷 것.
+					CollisionReport report{ gLastSnapshotTick, std::stoi(input.substr(4)) };
+					client.Send<TClientSchema<ClientMessage::MSG_TAKE_DAMAGE>>(report);
+				}
 				else if (input.rfind("map ", 0) == 0)
 				{
 					int mapId = std::stoi(input.substr(4));
-					client.SendMsg(0, (int)ClientMessage::MSG_PICK_MAP, &mapId, sizeof(int));
+					client.Send<TClientSchema<ClientMessage::MSG_PICK_MAP>>(mapId);
 				}
 				else if (input.rfind("char ", 0) == 0)
 				{
 					int charId = std::stoi(input.substr(5));
-					client.SendMsg(0, (int)ClientMessage::MSG_PICK_CHARACTER, &charId, sizeof(int));
+					client.Send<TClientSchema<ClientMessage::MSG_PICK_CHARACTER>>(charId);
 				}
 				else if (input.rfind("item ", 0) == 0)
 				{
-					int slot = -1, itemId = -1;
-					sscanf_s(input.c_str() + 5, "%d %d", &slot, &itemId);
-					int data[2] = { slot, itemId };
-					client.SendMsg(0, (int)ClientMessage::MSG_PICK_ITEM, data, sizeof(data));
+					PickItem pick{ -1, -1 };
+					sscanf_s(input.c_str() + 5, "%d %d", &pick.slot, &pick.itemId);
+					client.Send<TClientSchema<ClientMessage::MSG_PICK_ITEM>>(pick);
 				}
 				else
 				{
@@ -243,115 +364,16 @@ int main()
 				std::cout << "[ServerMsg " << msg.msgType << "] From: " << msg.senderId << ", Size: " << msg.body.size() << "\n";
 			}
 
-			if (msg.msgType == (int)ServerMessage::MSG_CONNECTED)
-			{
-				int myId;
-				memcpy(&myId, msg.body.data(), sizeof(int));
-				std::cout << "[System] Connected. My ID: " << myId << "\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_NEW_OWNER
-				&& msg.body.size() == sizeof(int))
-			{
-				int newOwnerId;
-				memcpy(&newOwnerId, msg.body.data(), sizeof(int));
-				std::cout << "[System] New Room Owner is: " << newOwnerId << "\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_CONNECTED_REJECT)
-			{
-				std::string reason(msg.body.begin(), msg.body.end());
-				std::cout << "[System] Connection rejected: " << reason << "\n";
-				exit(0);
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_JOIN)
-			{
-				int id;
-				if (msg.body.size() == sizeof(int))
-				{
-					memcpy(&id, msg.body.data(), sizeof(int));
-					std::cout << "[System] Player joined: " << id << "\n";
-				}
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_DISCONNECT)
-			{
-				int id;
-				if (msg.body.size() == sizeof(int))
-				{
-					memcpy(&id, msg.body.data(), sizeof(int));
-					std::cout << "[System] Player disconnected: " << id << "\n";
-				}
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_GAME_OVER)
-			{
-				if (!msg.body.empty())
-					std::cout << "[Game Over] " << msg.body.data() << "\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_MOVE_UP)
-			{
-				std::cout << "[Game] Player " << msg.senderId << " moved UP\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_MOVE_DOWN)
-			{
-				std::cout << "[Game] Player " << msg.senderId << " moved DOWN\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_PLAYER_DEAD)
-			{
-				std::cout << "[Game] Player " << msg.senderId << " is DEAD\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_ROOM_FULL_INFO
-				&& msg.body.size() >= sizeof(int) * 3)
+			// 모르는 메시지나 스키마와 다른 바디는 버림.
+			if (!IsValidServerBody(msg.msgType, msg.body.data(), (int)msg.body.size()))
 			{
-				const char* ptr = msg.body.data();
-				int ownerId, mapId, playerCount;
-				memcpy(&ownerId, ptr, sizeof(int)); ptr += sizeof(int);
-				memcpy(&mapId, ptr, sizeof(int)); ptr += sizeof(int);
-				memcpy(&playerCount, ptr, sizeof(int)); ptr += sizeof(int);
-				std::cout << "[ROOM_INFO] Owner: " << ownerId << ", Map: " << mapId << ", Players: " << playerCount << "\n";
-
-				for (int i = 0; i < playerCount; ++i)
-				{
-					int id, items[3];
-					bool ready;
-					memcpy(&id, ptr, sizeof(int)); ptr += sizeof(int);
-					memcpy(&ready, ptr, sizeof(bool)); ptr += sizeof(bool);
-					memcpy(items, ptr, sizeof(int) * 3); ptr += sizeof(int) * 3;
-					std::cout << "  Player " << id << " - Ready: " << (ready ? "Yes" : "No")
-						<< ", Items: [" << items[0] << ", " << items[1] << ", " << items[2] << "]\n";
-				}
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_START_ACK)
-			{
-				std::cout << "[Game] Game Started: " << msg.body.data() << "\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_READY)
-			{
-				std::cout << "[Game] Player " << msg.senderId << " is READY\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_UNREADY)
-			{
-				std::cout << "[Game] Player " << msg.senderId << " is UNREADY\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_PICK_MAP
-				&& msg.body.size() == sizeof(int))
-			{
-				int mapId;
-				memcpy(&mapId, msg.body.data(), sizeof(int));
-				std::cout << "[Game] Player " << msg.senderId << " selected Map ID: " << mapId << "\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_PICK_CHARACTER
-				&& msg.body.size() == sizeof(int))
-			{
-				int charId;
-				memcpy(&charId, msg.body.data(), sizeof(int));
-				std::cout << "[Game] Player " << msg.senderId << " picked Character: " << charId << "\n";
-			}
-			else if (msg.msgType == (int)ServerMessage::MSG_PICK_ITEM
-				&& msg.body.size() == sizeof(int) * 2)
-			{
-				int slot, itemId;
-				memcpy(&slot, msg.body.data(), sizeof(int));
-				memcpy(&itemId, msg.body.data() + sizeof(int), sizeof(int));
-				std::cout << "[Game] Player " << msg.senderId << " equipped item " << itemId << " in slot " << slot << "\n";
+				std::cout << "[Client] Invalid body for message " << msg.msgType << "\n";
+				continue;
 			}
+
+			FServerHandler handler = handlers[msg.msgType];
+			if (handler)
+				handler(msg);
 		}
 		std::this_thread::sleep_for(std::chrono::milliseconds(10));
 	}
@@ -37,7 +37,12 @@ public:
 	inline const int GetSelectableItemCount() { return mConfigData.SelectableItemCount; }
 
 	//인덱스에 따른 캐릭터 가져오기.
-	inline const FCharacterState GetCharacterState(int index) { return mCharacterInfoDatas[index]; }
+	// 여러 샤드가 동시에 읽으므로 operator[] 로 맵을 건드리지 않음. 없으면 기본값.
+	inline const FCharacterState GetCharacterState(int index)
+	{
+		auto it = mCharacterInfoDatas.find(index);
+		return it != mCharacterInfoDatas.end() ? it->second : FCharacterState();
+	}
 
 	// 내가 고른 캐릭의 데이터
 	inline const FCharacterState GetSelectedCharacterState() { return mCharacterInfoDatas[curSelectedCharacterIndex]; }
@@ -46,7 +51,12 @@ public:
 	inline const int GetSelectedCharacterIndex() { return curSelectedCharacterIndex; }
 
 	inline const int GetMapInfoCount() { return mMapInfoDatasByIndex.size(); }
-	inline const FMapInfo GetMapInfo(int index) { return mMapInfoDatasByIndex[index]; }
+	inline const FMapInfo GetMapInfo(int index)
+	{
+		auto it = mMapInfoDatasByIndex.find(index);
+		return it != mMapInfoDatasByIndex.end() ? it->second : FMapInfo();
+	}
+	inline const std::map<int, FMapInfo>& GetMapInfoDatas() const { return mMapInfoDatasByIndex; }
 	inline const FMapInfo GetSelectedMapInfo() { return mMapInfoDatasByIndex[curSelectedMapIndex]; }
 	inline const int GetSelectedMapIndex() { return curSelectedMapIndex; }
 	inline const int GetLineNodeCountInSelectedMap() { return mMapInfoDatasByIndex[curSelectedMapIndex].lineNodes.size(); }
@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+
+// 틱마다 하나씩 넣는 고정 크기 기록. 꽉 차면 제일 오래된 것부터 덮어씀.
+// 배열을 안에 들고 있어서 넣고 찾을때 할당이 없음.
+// 틱을 빠짐없이 이어서 넣는다고 보고, 찾을때는 최신 틱과의 차이로 칸을 바로 계산함.
+template<typename T, int Capacity>
+class CHistoryRing
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+private:
+	T mFrames[Capacity];
+	int mTicks[Capacity];
+	int mHead = 0;		// 다음에 쓸 칸.
+	int mCount = 0;
+
+public:
+	inline int GetCount() const { return mCount; }
+
+	void Clear()
+	{
+		mHead = 0;
+		mCount = 0;
+	}
+
+	void Push(int tick, const T& frame)
+	{
+		mFrames[mHead] = frame;
+		mTicks[mHead] = tick;
+		mHead = (mHead + 1) & (Capacity - 1);
+
+		if (mCount < Capacity)
+			mCount++;
+	}
+
+	// 가진 범위 밖이거나 중간에 틱이 빠졌으면 false.
+	bool Find(int tick, T& out) const
+	{
+		if (mCount == 0)
+			return false;
+
+		int latest = (mHead - 1) & (Capacity - 1);
+		int age = mTicks[latest] - tick;
+
+		if (age < 0 || age >= mCount)
+			return false;
+
+		int index = (latest - age) & (Capacity - 1);
+		if (mTicks[index] != tick)
+			return false;
+
+		out = mFrames[index];
+		return true;
+	}
+
+	bool GetLatest(T& out) const
+	{
+		if (mCount == 0)
+			return false;
+
+		out = mFrames[(mHead - 1) & (Capacity - 1)];
+		return true;
+	}
+};
@@ -120,6 +120,9 @@ struct FConfig
 	std::string ItemFileName;
 	std::string StatFileName;
 	int SelectableItemCount;
+	float ProtectionDuration = 2.0f;	// 스턴이 풀린 뒤 무적 시간 (초).
+	float DeadReckoningHeightError = 2.0f;	// --dead-reckoning 일때 높이를 다시 보내기 전까지 봐주는 오차 (픽셀).
+	float DeadReckoningDistanceError = 2.0f;	// --dead-reckoning 일때 거리를 다시 보내기 전까지 봐주는 오차 (맵 거리 단위).
 };
 
 
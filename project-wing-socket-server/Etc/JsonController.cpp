@@ -211,6 +211,16 @@ bool CJsonController::ParseJson(const nlohmann::json& json, FConfig& data)
 	if (json.contains("selectable_item_count"))
 		data.SelectableItemCount = json["selectable_item_count"].get<int>();
 
+	if (json.contains("protection_duration"))
+		data.ProtectionDuration = json["protection_duration"].get<float>();
+
+	// 높이 쪽은 거리 키가 생기기 전 이름 그대로 씀.
+	if (json.contains("dead_reckoning_error"))
+		data.DeadReckoningHeightError = json["dead_reckoning_error"].get<float>();
+
+	if (json.contains("dead_reckoning_distance_error"))
+		data.DeadReckoningDistanceError = json["dead_reckoning_distance_error"].get<float>();
+
 	return true;
 }
 
@@ -0,0 +1,94 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+
+// 여러 스레드가 넣고 한 스레드만 꺼내는 락 없는 고정 크기 큐.
+// 칸마다 순서 번호를 두고, 넣는 쪽은 쓸 칸을 CAS 로 잡은 뒤 값을 쓰고 번호를 올림.
+// 미리 잡아둔 배열만 돌려써서 넣고 꺼낼때 힙 할당이 없음. T 는 값 복사되는 작은 구조체여야 함.
+template<typename T, size_t Capacity>
+class CMpscQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+private:
+	struct FSlot
+	{
+		// pos 와 같으면 비어서 넣을 수 있고, pos + 1 이면 값이 들어 있음.
+		std::atomic<size_t> seq;
+		T value;
+	};
+
+	FSlot* mSlots;
+
+	// 넣는 쪽과 꺼내는 쪽 위치가 같은 캐시 라인에 있으면 서로 밀어내서 띄워둠.
+	char mPad0[64];
+	std::atomic<size_t> mEnqueuePos{ 0 };
+	char mPad1[64];
+
+	// 꺼내는 쪽만 씀.
+	size_t mDequeuePos = 0;
+
+public:
+	CMpscQueue()
+	{
+		mSlots = new FSlot[Capacity];
+
+		for (size_t i = 0; i < Capacity; i++)
+			mSlots[i].seq.store(i, std::memory_order_relaxed);
+	}
+
+	~CMpscQueue()
+	{
+		delete[] mSlots;
+	}
+
+	CMpscQueue(const CMpscQueue&) = delete;
+	CMpscQueue& operator=(const CMpscQueue&) = delete;
+
+	// 아무 스레드에서나. 꽉 찼으면 false.
+	bool Push(const T& value)
+	{
+		size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+
+		while (true)
+		{
+			FSlot& slot = mSlots[pos & (Capacity - 1)];
+			size_t seq = slot.seq.load(std::memory_order_acquire);
+			long long diff = (long long)seq - (long long)pos;
+
+			if (diff == 0)
+			{
+				if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					slot.value = value;
+					slot.seq.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				// 꺼내는 쪽이 한바퀴 뒤처져 있음.
+				return false;
+			}
+			else
+			{
+				pos = mEnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// 꺼내는 스레드에서만.
+	// 앞 칸을 잡은 쪽이 아직 쓰는 중이면 그 뒤에 들어온 것도 그게 끝날때까지 안 보임.
+	bool Pop(T& out)
+	{
+		FSlot& slot = mSlots[mDequeuePos & (Capacity - 1)];
+
+		if (slot.seq.load(std::memory_order_acquire) != mDequeuePos + 1)
+			return false;
+
+		out = slot.value;
+		slot.seq.store(mDequeuePos + Capacity, std::memory_order_release);
+		mDequeuePos++;
+		return true;
+	}
+};
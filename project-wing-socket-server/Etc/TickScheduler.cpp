@@ -0,0 +1,172 @@
+﻿#include "Etc/TickScheduler.h"
+
+CTickScheduler::CTickScheduler()
+{
+
+}
+
+CTickScheduler::~CTickScheduler()
+{
+	if (mTimer)
+		CloseHandle(mTimer);
+}
+
+bool CTickScheduler::Init(const std::string& name)
+{
+	mName = name;
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	mFrequency = frequency.QuadPart;
+	mTickInterval = mFrequency / TICK_RATE;
+
+	mTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+	// 고해상도를 못 쓰는 OS 면 일반 타이머로. 이때는 틱 지터가 커짐.
+	if (mTimer == nullptr)
+	{
+		std::cout << "[" << mName << "] high resolution timer unavailable.\n";
+		mTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	}
+
+	if (mTimer == nullptr)
+		return false;
+
+	mLastReportTime = GetTickCount64();
+	mWakeTime = GetNow();
+	mLoadWindowStart = mWakeTime;
+	return true;
+}
+
+long long CTickScheduler::GetNow() const
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return now.QuadPart;
+}
+
+void CTickScheduler::SetActive(bool isActive)
+{
+	if (mIsActive == isActive)
+		return;
+
+	mIsActive = isActive;
+
+	if (isActive)
+		mIsRestartPending = true;
+}
+
+int CTickScheduler::WaitForNextTicks(HANDLE wakeEvent)
+{
+	mBusyTime += GetNow() - mWakeTime;
+
+	int dueTicks = Wait(wakeEvent);
+
+	mWakeTime = GetNow();
+	UpdateLoad();
+	return dueTicks;
+}
+
+void CTickScheduler::UpdateLoad()
+{
+	long long elapsed = mWakeTime - mLoadWindowStart;
+	if (elapsed < mFrequency * TICK_LOAD_WINDOW_MS / 1000)
+		return;
+
+	mLoad = (float)mBusyTime / elapsed;
+	mBusyTime = 0;
+	mLoadWindowStart = mWakeTime;
+}
+
+int CTickScheduler::Wait(HANDLE wakeEvent)
+{
+	// 진행중인 게임이 없으면 일이 들어올때까지 잠. 사용률 갱신을 위해 가끔 깨어남.
+	if (!mIsActive)
+	{
+		WaitForSingleObject(wakeEvent, TICK_LOAD_WINDOW_MS);
+		return 0;
+	}
+
+	if (mIsRestartPending)
+	{
+		mIsRestartPending = false;
+		mNextTickTime = GetNow() + mTickInterval;
+	}
+
+	long long now = GetNow();
+
+	if (now < mNextTickTime)
+	{
+		// 100ns 단위. 음수면 상대 시간.
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -((mNextTickTime - now) * 10000000 / mFrequency);
+
+		if (dueTime.QuadPart < 0 && SetWaitableTimer(mTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+		{
+			HANDLE handles[2] = { mTimer, wakeEvent };
+
+			if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+				return 0;
+		}
+
+		now = GetNow();
+
+		if (now < mNextTickTime)
+			return 0;
+	}
+
+	mTickStartTime = now;
+
+	long long late = now - mNextTickTime;
+	if (late > mMaxLateTime)
+		mMaxLateTime = late;
+
+	int dueTicks = 1 + (int)(late / mTickInterval);
+
+	if (dueTicks > TICK_MAX_CATCH_UP)
+	{
+		// 너무 밀렸으면 다 따라잡지 않고 버림. 다음 틱은 지금부터 다시 셈.
+		mSkippedTicks += dueTicks - TICK_MAX_CATCH_UP;
+		dueTicks = TICK_MAX_CATCH_UP;
+		mNextTickTime = now + mTickInterval;
+	}
+	else
+	{
+		mNextTickTime += dueTicks * mTickInterval;
+	}
+
+	mTickCount += dueTicks;
+	return dueTicks;
+}
+
+void CTickScheduler::EndTicks()
+{
+	long long workTime = GetNow() - mTickStartTime;
+
+	if (workTime > mMaxWorkTime)
+		mMaxWorkTime = workTime;
+
+	if (workTime > mTickInterval)
+		mOverrunCount++;
+}
+
+void CTickScheduler::ReportStats()
+{
+	ULONGLONG now = GetTickCount64();
+	if (now - mLastReportTime < TICK_REPORT_INTERVAL_MS)
+		return;
+
+	mLastReportTime = now;
+
+	double toMs = 1000.0 / mFrequency;
+
+	std::cout << "[" << mName << "] ticks " << mTickCount
+		<< ", overrun " << mOverrunCount
+		<< ", skipped " << mSkippedTicks
+		<< ", max work " << mMaxWorkTime * toMs << "ms"
+		<< ", max late " << mMaxLateTime * toMs << "ms"
+		<< ", load " << (int)(mLoad * 100) << "%\n";
+
+	mMaxWorkTime = 0;
+	mMaxLateTime = 0;
+}
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+
+// 초당 게임 틱 수.
+#define TICK_RATE 60
+
+// 한번 깨어났을때 밀린 틱을 최대 몇번까지 몰아서 돌릴지. 넘으면 버리고 기준 시각을 다시 잡음.
+#define TICK_MAX_CATCH_UP 4
+
+// 틱 통계 출력 주기.
+#define TICK_REPORT_INTERVAL_MS 10000
+
+// 사용률을 새로 계산하는 주기. 쉬는 중에도 이 간격으로 깨어나서 갱신함.
+#define TICK_LOAD_WINDOW_MS 1000
+
+// 오래된 SDK 에는 없음. Windows 10 1803 이상에서만 먹힘.
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// 고정 간격 게임 틱 스케줄러. 샤드마다 하나씩 가짐.
+// 틱 경계 시각을 절대값으로 들고 있다가 고해상도 waitable timer 로 그때까지 잠.
+// 진행중인 게임이 없으면 깨우기 이벤트가 올때까지 무기한 잠.
+// 가진 샤드 스레드에서만 씀.
+class CTickScheduler
+{
+private:
+	std::string mName;
+
+	HANDLE mTimer = nullptr;
+
+	// QueryPerformanceCounter 단위.
+	long long mFrequency = 0;
+	long long mTickInterval = 0;
+	long long mNextTickTime = 0;
+	long long mTickStartTime = 0;
+
+	bool mIsActive = false;
+
+	// 쉬다가 다시 켜졌으면 기준 시각을 새로 잡아야 함.
+	bool mIsRestartPending = false;
+
+	long long mTickCount = 0;
+	long long mOverrunCount = 0;
+	long long mSkippedTicks = 0;
+	long long mMaxWorkTime = 0;
+	long long mMaxLateTime = 0;
+	ULONGLONG mLastReportTime = 0;
+
+	// 대기 밖에서 보낸 시간 / 전체 시간. 마지막 창 기준.
+	long long mWakeTime = 0;
+	long long mBusyTime = 0;
+	long long mLoadWindowStart = 0;
+	float mLoad = 0.0f;
+
+public:
+	CTickScheduler();
+	~CTickScheduler();
+
+	bool Init(const std::string& name);
+
+	inline float GetTickDelta() const { return 1.0f / TICK_RATE; }
+
+	// 게임중인 방이 생기거나 다 끝났을때 부름.
+	void SetActive(bool isActive);
+
+	// 다음 틱 경계나 wakeEvent 까지 잠. 이번에 돌려야 할 틱 수를 돌려줌 (따라잡기 포함).
+	// 틱 경계 전에 wakeEvent 로 깨어났으면 0.
+	int WaitForNextTicks(HANDLE wakeEvent);
+
+	// 틱 처리가 끝났을때 부름. 틱 간격보다 오래 걸렸으면 overrun 으로 셈.
+	void EndTicks();
+
+	void ReportStats();
+
+	// 0~1. 마지막 TICK_LOAD_WINDOW_MS 동안 잠들어 있지 않았던 시간 비율.
+	inline float GetLoad() const { return mLoad; }
+
+private:
+	long long GetNow() const;
+	int Wait(HANDLE wakeEvent);
+	void UpdateLoad();
+};
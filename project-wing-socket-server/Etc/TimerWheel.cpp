@@ -0,0 +1,83 @@
+﻿#include "Etc/TimerWheel.h"
+
+void CTimerWheel::Reset(int tick)
+{
+	for (auto& level : mSlots)
+	{
+		for (auto& slot : level)
+			slot.clear();
+	}
+
+	mCurrentTick = tick;
+	mCount = 0;
+}
+
+void CTimerWheel::Schedule(int delayTicks, int type, int targetId)
+{
+	FTimer timer;
+	timer.expireTick = mCurrentTick + (delayTicks < 1 ? 1 : delayTicks);
+	timer.type = type;
+	timer.targetId = targetId;
+
+	Insert(timer);
+	mCount++;
+}
+
+void CTimerWheel::Insert(const FTimer& timer)
+{
+	const int mask = TIMER_WHEEL_SLOTS - 1;
+	int remain = timer.expireTick - mCurrentTick;
+
+	if (remain < TIMER_WHEEL_SLOTS)
+	{
+		mSlots[0][timer.expireTick & mask].push_back(timer);
+		return;
+	}
+
+	// 2단계 범위를 넘으면 마지막 칸에 두고 내려올때 다시 계산함.
+	int limit = TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOTS;
+	int tick = remain < limit ? timer.expireTick : mCurrentTick + limit - TIMER_WHEEL_SLOTS;
+
+	mSlots[1][(tick >> TIMER_WHEEL_SLOT_BITS) & mask].push_back(timer);
+}
+
+void CTimerWheel::Cascade()
+{
+	const int mask = TIMER_WHEEL_SLOTS - 1;
+	std::vector<FTimer>& slot = mSlots[1][(mCurrentTick >> TIMER_WHEEL_SLOT_BITS) & mask];
+
+	if (slot.empty())
+		return;
+
+	mFiring.swap(slot);
+
+	for (auto& timer : mFiring)
+		Insert(timer);
+
+	mFiring.clear();
+}
+
+void CTimerWheel::Advance(int tick, const TimerCallback& callback)
+{
+	const int mask = TIMER_WHEEL_SLOTS - 1;
+
+	while (mCurrentTick < tick)
+	{
+		mCurrentTick++;
+
+		if ((mCurrentTick & mask) == 0)
+			Cascade();
+
+		std::vector<FTimer>& slot = mSlots[0][mCurrentTick & mask];
+		if (slot.empty())
+			continue;
+
+		mFiring.swap(slot);
+		mCount -= (int)mFiring.size();
+
+		for (auto& timer : mFiring)
+			callback(timer);
+
+		mFiring.clear();
+	}
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+
+// 한 단계의 칸 수. 1단계는 64틱 (60틱 기준 약 1초), 2단계는 64 * 64틱 (약 68초).
+#define TIMER_WHEEL_SLOTS 64
+#define TIMER_WHEEL_SLOT_BITS 6
+
+// 2단계보다 먼 타이머는 2단계 마지막 칸에 두고, 내려올때마다 다시 넣어서 맞춤.
+#define TIMER_WHEEL_LEVELS 2
+
+struct FTimer
+{
+	int expireTick;
+	int type;		// 쓰는 쪽이 정하는 종류.
+	int targetId;	// 쓰는 쪽이 정하는 대상. 불릴때 아직 유효한지는 쓰는 쪽이 확인함.
+};
+
+// 틱 단위 계층 타이머 휠.
+// 넣을때 남은 틱 수로 칸을 정하고, 틱마다 지금 칸에 있는 것만 꺼내서 부름.
+// 그래서 틱당 비용은 걸려있는 타이머 수가 아니라 만료되는 수에 비례함.
+// 1단계 칸을 한바퀴 돌때마다 2단계 칸 하나를 1단계로 내려보냄.
+// 취소는 없음. 대상이 사라졌으면 불릴때 무시하면 됨.
+// 가진 스레드에서만 씀.
+class CTimerWheel
+{
+public:
+	using TimerCallback = std::function<void(const FTimer&)>;
+
+private:
+	std::vector<FTimer> mSlots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+
+	// 지금 부르는 칸. 콜백 안에서 새로 거는 타이머가 이 목록을 건드리지 않게 떼어둠.
+	std::vector<FTimer> mFiring;
+
+	int mCurrentTick = 0;
+	int mCount = 0;
+
+public:
+	// 걸려있는 타이머를 다 버리고 tick 부터 다시 셈.
+	void Reset(int tick);
+
+	// delayTicks 틱 뒤에 부름. 1 보다 작으면 다음 틱.
+	void Schedule(int delayTicks, int type, int targetId);
+
+	// tick 까지 진행하면서 만료된 타이머를 부름.
+	void Advance(int tick, const TimerCallback& callback);
+
+	inline int GetCount() const { return mCount; }
+	inline int GetCurrentTick() const { return mCurrentTick; }
+
+private:
+	void Insert(const FTimer& timer);
+	void Cascade();
+};
@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Interface/IPlayerStatController.h"
+#include "Network/Connection.h"
+#include "Etc/HistoryRing.h"
+
+// 60 틱 기준 약 0.5초. RTT 150ms 에 스냅샷 보간 지연까지 들어감.
+#define PLAYER_HISTORY_TICKS 32
+
+// 틱마다 남기는 플레이어 상태. 클라 충돌 신고를 그 시점 상태로 확인할때 씀.
+struct FPlayerHistoryFrame
+{
+	float height;
+	float distance;
+	int flags;	// EPlayerSimFlag
+};
+
+class CRoom;
+
+struct Client : public IPlayerStatController
+{
+	Connection* conn = nullptr;
+	int id;
+
+	// 들어가 있는 방. 로비에 있으면 nullptr.
+	CRoom* room = nullptr;
+
+	bool isReady = false;
+	bool isAlive = true;
+
+	// MSG_PROTOCOL_HELLO 로 정한 버전. 연결 단위라 Init 에서 안 지움.
+	int protocolVersion = PROTOCOL_VERSION_V1;
+
+	// v4 클라가 마지막으로 받았다고 알려준 스냅샷 번호. 0 이면 아직 없음.
+	unsigned int snapshotAck = 0;
+
+	// 마지막 스냅샷에 실린 이 플레이어 상태. 데드 레커닝 기준점을 이어서 씀.
+	FPackedPlayerState reckonState;
+
+	int characterId = 0;
+	int itemSlots[3] = { -1, -1, -1 };
+
+	// 게임중이면 샤드 CPlayerSim 의 칸 번호. 아니면 -1.
+	// 높이/거리/HP 같은 인게임 값은 게임중에는 거기에만 있음.
+	int simSlot = -1;
+
+	// 서버가 장애물을 보낼때 다음에 보낼 칸 번호.
+	int nextObstacleStep = 1;
+
+	// 서버 충돌 판정용. 칸이 바뀔때만 그 칸의 통로 범위를 다시 읽어둠.
+	int collisionStep = -1;
+	float corridorMin = 0.0f;
+	float corridorMax = 0.0f;
+	float collisionHalfHeight = 0.0f;
+
+	CHistoryRing<FPlayerHistoryFrame, PLAYER_HISTORY_TICKS> history;
+
+	void Init()
+	{
+		isReady = false;
+		isAlive = true;
+		characterId = 0;
+		itemSlots[0] = -1;
+		itemSlots[1] = -1;
+		itemSlots[2] = -1;
+		nextObstacleStep = 1;
+		collisionStep = -1;
+		snapshotAck = 0;
+		history.Clear();
+
+		std::cout << "client_" << id
+			<< " Init(): " << "\n";
+	}
+};
@@ -0,0 +1,49 @@
+﻿#include "Game/CollisionManager.h"
+#include "Game/ObstacleCourse.h"
+#include "Etc/DataStorageManager.h"
+
+DEFINITION_SINGLE(CCollisionManager);
+
+CCollisionManager::CCollisionManager()
+{
+
+}
+
+CCollisionManager::~CCollisionManager()
+{
+
+}
+
+void CCollisionManager::Build()
+{
+	mTimelinesByMap.clear();
+
+	// 라인 노드는 화면 아래가 0 인 좌표라서 가운데가 0 인 서버 높이로 바꿔둠.
+	const float centerY = OBSTACLE_COURSE_HEIGHT * 0.5f;
+
+	for (auto& pair : CDataStorageManager::GetInst()->GetMapInfoDatas())
+	{
+		const FMapInfo& info = pair.second;
+		if (info.lineNodes.empty())
+			continue;
+
+		FCollisionTimeline& timeline = mTimelinesByMap[info.Index];
+		timeline.corridors.reserve(info.lineNodes.size());
+
+		for (auto& node : info.lineNodes)
+		{
+			FCorridor corridor;
+			corridor.minHeight = std::min(node.TopYPos, node.BottomYPos) - centerY;
+			corridor.maxHeight = std::max(node.TopYPos, node.BottomYPos) - centerY;
+			timeline.corridors.push_back(corridor);
+		}
+
+		std::cout << "[Collision] map " << info.Index << " timeline: " << timeline.corridors.size() << " nodes\n";
+	}
+}
+
+const FCollisionTimeline* CCollisionManager::FindTimeline(int mapIndex) const
+{
+	auto it = mTimelinesByMap.find(mapIndex);
+	return it != mTimelinesByMap.end() ? &it->second : nullptr;
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Etc/JsonContainer.h"
+
+// 한 칸에서 플레이어가 있어도 되는 높이 범위. 서버 높이 기준 (가운데 0).
+struct FCorridor
+{
+	float minHeight = 0.0f;
+	float maxHeight = 0.0f;
+};
+
+// 맵 하나의 라인 노드를 칸 번호로 바로 찾게 펴둔 것.
+// 라인 노드 하나가 장애물 한칸 (OBSTACLE_STEP_DISTANCE) 이고, 끝까지 가면 처음부터 반복.
+struct FCollisionTimeline
+{
+	std::vector<FCorridor> corridors;
+
+	inline const FCorridor& GetCorridor(int step) const
+	{
+		return corridors[step % (int)corridors.size()];
+	}
+};
+
+// 맵 데이터를 읽은 뒤 한번 만들어두고 이후로는 읽기만 함. 여러 샤드가 같이 씀.
+class CCollisionManager
+{
+private:
+	std::map<int, FCollisionTimeline> mTimelinesByMap;
+
+public:
+	// CDataStorageManager 에 맵이 다 들어온 뒤에 호출.
+	void Build();
+
+	// 라인 노드가 없는 맵이면 nullptr.
+	const FCollisionTimeline* FindTimeline(int mapIndex) const;
+
+private:
+	DECLARE_SINGLE(CCollisionManager)
+};
@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Network/Protocol.h"
+
+// 장애물 한칸 길이 (m). 거리가 이만큼 늘때마다 다음 장애물.
+#define OBSTACLE_STEP_DISTANCE 16.0f
+
+// 장애물 높이 범위. 화면 높이와 같고 가운데가 0.
+#define OBSTACLE_COURSE_HEIGHT 720
+
+// 서버가 장애물을 정할때 한번에 미리 보내두는 칸 수.
+#define OBSTACLE_LOOKAHEAD_STEPS 16
+
+// 보내둔 마지막 칸까지 이만큼 남으면 다음 묶음을 보냄.
+#define OBSTACLE_REFILL_MARGIN 4
+
+namespace EObstacleMode
+{
+	enum Type
+	{
+		// 시드만 알려주고 클라가 코스를 만듦.
+		ClientSeeded,
+
+		// 시드는 서버만 알고 앞으로 지날 칸들을 묶어서 보냄. 클라가 코스를 미리 알 수 없음.
+		ServerStreamed
+	};
+}
+
+// 방마다 시드 하나로 정해지는 장애물 코스.
+// 칸 번호와 시드만 섞어서 값을 만들기 때문에 아무 칸이나 바로 구할 수 있고 저장할 필요가 없음.
+// 클라도 MSG_START_ACK 로 받은 시드로 같은 코스를 만듦. 여기 계산을 바꾸면 클라도 같이 바꿔야 함.
+inline unsigned int HashObstacleStep(unsigned int seed, int step, unsigned int salt)
+{
+	unsigned int h = seed ^ ((unsigned int)step * 0x9E3779B9u) ^ (salt * 0x85EBCA6Bu);
+	h ^= h >> 16;
+	h *= 0x7FEB352Du;
+	h ^= h >> 15;
+	h *= 0x846CA68Bu;
+	h ^= h >> 16;
+	return h;
+}
+
+inline Obstacle MakeObstacle(unsigned int seed, int step)
+{
+	Obstacle obs;
+	obs.scale = (float)(HashObstacleStep(seed, step, 0) % 50) + 100.0f;
+	obs.rotation = (float)(HashObstacleStep(seed, step, 1) % 360);
+	obs.height = (float)(HashObstacleStep(seed, step, 2) % OBSTACLE_COURSE_HEIGHT) - OBSTACLE_COURSE_HEIGHT * 0.5f;
+	return obs;
+}
+
+// 이 거리까지 지나온 칸 번호.
+inline int GetObstacleStep(float distance)
+{
+	return static_cast<int>(distance / OBSTACLE_STEP_DISTANCE);
+}
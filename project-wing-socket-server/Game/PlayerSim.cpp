@@ -0,0 +1,223 @@
+﻿#include "Game/PlayerSim.h"
+#include "Game/Room.h"
+#include <emmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+void CPlayerSim::Add(Client* owner, const FPlayerSimRow& row)
+{
+	mHeight.push_back(row.height);
+	mDistance.push_back(row.distance);
+	mHp.push_back(row.hp);
+	mDex.push_back(row.dex);
+	mSpeed.push_back(row.speed);
+	mDef.push_back(row.def);
+	mMoveDir.push_back(row.moveDir);
+	mBoost.push_back(row.boost);
+	mFlags.push_back(row.flags);
+	mOwners.push_back(owner);
+
+	owner->simSlot = (int)mOwners.size() - 1;
+}
+
+FPlayerSimRow CPlayerSim::Remove(int slot)
+{
+	FPlayerSimRow row = Read(slot);
+	int last = (int)mOwners.size() - 1;
+
+	mOwners[slot]->simSlot = -1;
+
+	if (slot != last)
+	{
+		mHeight[slot] = mHeight[last];
+		mDistance[slot] = mDistance[last];
+		mHp[slot] = mHp[last];
+		mDex[slot] = mDex[last];
+		mSpeed[slot] = mSpeed[last];
+		mDef[slot] = mDef[last];
+		mMoveDir[slot] = mMoveDir[last];
+		mBoost[slot] = mBoost[last];
+		mFlags[slot] = mFlags[last];
+		mOwners[slot] = mOwners[last];
+		mOwners[slot]->simSlot = slot;
+	}
+
+	mHeight.pop_back();
+	mDistance.pop_back();
+	mHp.pop_back();
+	mDex.pop_back();
+	mSpeed.pop_back();
+	mDef.pop_back();
+	mMoveDir.pop_back();
+	mBoost.pop_back();
+	mFlags.pop_back();
+	mOwners.pop_back();
+
+	return row;
+}
+
+FPlayerSimRow CPlayerSim::Read(int slot) const
+{
+	FPlayerSimRow row;
+	row.height = mHeight[slot];
+	row.distance = mDistance[slot];
+	row.hp = mHp[slot];
+	row.dex = mDex[slot];
+	row.speed = mSpeed[slot];
+	row.def = mDef[slot];
+	row.moveDir = mMoveDir[slot];
+	row.boost = mBoost[slot];
+	row.flags = mFlags[slot];
+	return row;
+}
+
+void CPlayerSim::Step(float dt, float drainPerTick)
+{
+	int count = GetCount();
+	int done = 0;
+
+#ifdef __AVX2__
+	done = StepAvx2(0, count, dt, drainPerTick);
+#else
+	done = StepSse(0, count, dt, drainPerTick);
+#endif
+
+	// 묶음에 못 들어간 나머지.
+	StepScalar(done, count, dt, drainPerTick);
+}
+
+// 스턴이 아니면 이동, 스턴도 보호도 아니면 HP 감소. 예전 Room::Update 의 플레이어 루프와 같음.
+void CPlayerSim::StepScalar(int begin, int end, float dt, float drainPerTick)
+{
+	const int activeMask = EPlayerSimFlag::Alive | EPlayerSimFlag::Simulating;
+	const float minHeight = SCREEN_HEIGHT * -0.5f;
+	const float maxHeight = SCREEN_HEIGHT * 0.5f;
+
+	for (int i = begin; i < end; i++)
+	{
+		int flags = mFlags[i];
+		if ((flags & activeMask) != activeMask || (flags & EPlayerSimFlag::Stun))
+			continue;
+
+		mHeight[i] = clamp(mHeight[i] + mDex[i] * dt * mMoveDir[i], minHeight, maxHeight);
+		mDistance[i] += mSpeed[i] * dt * 0.01f * mBoost[i];
+
+		if (!(flags & EPlayerSimFlag::Protection))
+		{
+			float damage = drainPerTick - drainPerTick * (mDef[i] * 0.01f);
+			mHp[i] -= damage < 0.0f ? 0.0f : damage;
+		}
+	}
+}
+
+// SSE2 는 x64 면 항상 있음. 4명씩.
+// 분기 대신 조건을 마스크로 만들어서 값을 골라 씀.
+static inline __m128 SelectPs(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 HasFlagPs(__m128i flags, __m128i flag)
+{
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, flag), flag));
+}
+
+int CPlayerSim::StepSse(int begin, int end, float dt, float drainPerTick)
+{
+	const __m128 vDt = _mm_set1_ps(dt);
+	const __m128 vZero = _mm_setzero_ps();
+	const __m128 vCentiDt = _mm_set1_ps(dt * 0.01f);
+	const __m128 vDrain = _mm_set1_ps(drainPerTick);
+	const __m128 vCenti = _mm_set1_ps(0.01f);
+	const __m128 vMinHeight = _mm_set1_ps(SCREEN_HEIGHT * -0.5f);
+	const __m128 vMaxHeight = _mm_set1_ps(SCREEN_HEIGHT * 0.5f);
+	const __m128i vActive = _mm_set1_epi32(EPlayerSimFlag::Alive | EPlayerSimFlag::Simulating);
+	const __m128i vStun = _mm_set1_epi32(EPlayerSimFlag::Stun);
+	const __m128i vProtection = _mm_set1_epi32(EPlayerSimFlag::Protection);
+
+	int i = begin;
+
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128i flags = _mm_loadu_si128((const __m128i*)&mFlags[i]);
+
+		// 스턴이 아니면 이동.
+		__m128 move = _mm_andnot_ps(HasFlagPs(flags, vStun), HasFlagPs(flags, vActive));
+
+		__m128 height = _mm_loadu_ps(&mHeight[i]);
+		__m128 movedHeight = _mm_add_ps(height, _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&mDex[i]), vDt), _mm_loadu_ps(&mMoveDir[i])));
+		movedHeight = _mm_min_ps(_mm_max_ps(movedHeight, vMinHeight), vMaxHeight);
+		height = SelectPs(move, movedHeight, height);
+
+		__m128 distance = _mm_loadu_ps(&mDistance[i]);
+		__m128 step = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&mSpeed[i]), vCentiDt), _mm_loadu_ps(&mBoost[i]));
+		distance = SelectPs(move, _mm_add_ps(distance, step), distance);
+
+		// 보호중이 아니면 거리만큼 HP 감소.
+		__m128 drain = _mm_andnot_ps(HasFlagPs(flags, vProtection), move);
+		__m128 damage = _mm_sub_ps(vDrain, _mm_mul_ps(vDrain, _mm_mul_ps(_mm_loadu_ps(&mDef[i]), vCenti)));
+		damage = _mm_max_ps(damage, vZero);
+		__m128 hp = _mm_loadu_ps(&mHp[i]);
+		hp = SelectPs(drain, _mm_sub_ps(hp, damage), hp);
+
+		_mm_storeu_ps(&mHeight[i], height);
+		_mm_storeu_ps(&mDistance[i], distance);
+		_mm_storeu_ps(&mHp[i], hp);
+	}
+
+	return i;
+}
+
+#ifdef __AVX2__
+// /arch:AVX2 로 빌드했을때만. 8명씩, 순서는 SSE 판과 같음.
+static inline __m256 HasFlagPs256(__m256i flags, __m256i flag)
+{
+	return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(flags, flag), flag));
+}
+
+int CPlayerSim::StepAvx2(int begin, int end, float dt, float drainPerTick)
+{
+	const __m256 vDt = _mm256_set1_ps(dt);
+	const __m256 vZero = _mm256_setzero_ps();
+	const __m256 vCentiDt = _mm256_set1_ps(dt * 0.01f);
+	const __m256 vDrain = _mm256_set1_ps(drainPerTick);
+	const __m256 vCenti = _mm256_set1_ps(0.01f);
+	const __m256 vMinHeight = _mm256_set1_ps(SCREEN_HEIGHT * -0.5f);
+	const __m256 vMaxHeight = _mm256_set1_ps(SCREEN_HEIGHT * 0.5f);
+	const __m256i vActive = _mm256_set1_epi32(EPlayerSimFlag::Alive | EPlayerSimFlag::Simulating);
+	const __m256i vStun = _mm256_set1_epi32(EPlayerSimFlag::Stun);
+	const __m256i vProtection = _mm256_set1_epi32(EPlayerSimFlag::Protection);
+
+	int i = begin;
+
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256i flags = _mm256_loadu_si256((const __m256i*)&mFlags[i]);
+
+		__m256 move = _mm256_andnot_ps(HasFlagPs256(flags, vStun), HasFlagPs256(flags, vActive));
+
+		__m256 height = _mm256_loadu_ps(&mHeight[i]);
+		__m256 movedHeight = _mm256_add_ps(height, _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(&mDex[i]), vDt), _mm256_loadu_ps(&mMoveDir[i])));
+		movedHeight = _mm256_min_ps(_mm256_max_ps(movedHeight, vMinHeight), vMaxHeight);
+		height = _mm256_blendv_ps(height, movedHeight, move);
+
+		__m256 distance = _mm256_loadu_ps(&mDistance[i]);
+		__m256 step = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(&mSpeed[i]), vCentiDt), _mm256_loadu_ps(&mBoost[i]));
+		distance = _mm256_blendv_ps(distance, _mm256_add_ps(distance, step), move);
+
+		__m256 drain = _mm256_andnot_ps(HasFlagPs256(flags, vProtection), move);
+		__m256 damage = _mm256_sub_ps(vDrain, _mm256_mul_ps(vDrain, _mm256_mul_ps(_mm256_loadu_ps(&mDef[i]), vCenti)));
+		damage = _mm256_max_ps(damage, vZero);
+		__m256 hp = _mm256_loadu_ps(&mHp[i]);
+		hp = _mm256_blendv_ps(hp, _mm256_sub_ps(hp, damage), drain);
+
+		_mm256_storeu_ps(&mHeight[i], height);
+		_mm256_storeu_ps(&mDistance[i], distance);
+		_mm256_storeu_ps(&mHp[i], hp);
+	}
+
+	// 남은게 4명 이상이면 SSE 로 한번 더.
+	return StepSse(i, end, dt, drainPerTick);
+}
+#endif
@@ -0,0 +1,100 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+
+struct Client;
+
+// 부스트중 거리 배율. 클라 데드 레커닝 식도 같은 값을 씀 (SNAPSHOT_RECKON_BOOST).
+#define PLAYER_BOOST_MULTIPLIER 2.0f
+
+namespace EPlayerSimFlag
+{
+	enum Type
+	{
+		Alive = 1 << 0,
+		Simulating = 1 << 1,	// 카운트다운이 끝나서 매 틱 움직이는 중.
+		Stun = 1 << 2,
+		Protection = 1 << 3
+	};
+}
+
+// 플레이어 한명의 인게임 상태. 샤드 사이로 방을 옮길때 값으로 들고 다님.
+struct FPlayerSimRow
+{
+	float height = 0.0f;
+	float distance = 0.0f;
+	float hp = 0.0f;
+	float dex = 0.0f;
+	float speed = 0.0f;
+	float def = 0.0f;
+	float moveDir = -1.0f;	// 위로 가면 1, 아래로 가면 -1.
+	float boost = 1.0f;		// 부스트중이면 PLAYER_BOOST_MULTIPLIER.
+	int flags = 0;
+};
+
+// 샤드 하나의 게임중인 플레이어 상태를 필드별 배열로 들고 있음 (SoA).
+// 방에 상관없이 샤드의 모든 플레이어를 한번에 훑으면서 SIMD 로 갱신함.
+// 중간을 빼면 마지막 칸을 당겨와서 항상 빈틈 없이 채워져 있음.
+// 샤드 스레드에서만 씀.
+class CPlayerSim
+{
+private:
+	std::vector<float> mHeight;
+	std::vector<float> mDistance;
+	std::vector<float> mHp;
+	std::vector<float> mDex;
+	std::vector<float> mSpeed;
+	std::vector<float> mDef;
+	std::vector<float> mMoveDir;
+	std::vector<float> mBoost;
+	std::vector<int> mFlags;
+
+	// 칸 주인. 칸이 당겨지면 주인의 simSlot 도 고침.
+	std::vector<Client*> mOwners;
+
+public:
+	inline int GetCount() const { return (int)mOwners.size(); }
+
+	// 새 칸을 만들고 owner->simSlot 에 적어둠.
+	void Add(Client* owner, const FPlayerSimRow& row);
+
+	// 칸을 빼고 그 값을 돌려줌. owner->simSlot 은 -1 이 됨.
+	FPlayerSimRow Remove(int slot);
+
+	FPlayerSimRow Read(int slot) const;
+
+	inline float GetHeight(int slot) const { return mHeight[slot]; }
+	inline float GetDistance(int slot) const { return mDistance[slot]; }
+	inline float GetHp(int slot) const { return mHp[slot]; }
+	inline float GetDex(int slot) const { return mDex[slot]; }
+	inline float GetSpeed(int slot) const { return mSpeed[slot]; }
+	inline float GetDef(int slot) const { return mDef[slot]; }
+	inline bool IsBoost(int slot) const { return mBoost[slot] > 1.0f; }
+	inline bool IsMovingUp(int slot) const { return mMoveDir[slot] > 0.0f; }
+	inline bool HasFlag(int slot, EPlayerSimFlag::Type flag) const { return (mFlags[slot] & flag) != 0; }
+
+	inline void SetHp(int slot, float hp) { mHp[slot] = hp; }
+	inline void SetBoost(int slot, bool isBoost) { mBoost[slot] = isBoost ? PLAYER_BOOST_MULTIPLIER : 1.0f; }
+	inline void SetMovingUp(int slot, bool isMovingUp) { mMoveDir[slot] = isMovingUp ? 1.0f : -1.0f; }
+
+	inline void SetFlag(int slot, EPlayerSimFlag::Type flag, bool isOn)
+	{
+		if (isOn)
+			mFlags[slot] |= flag;
+		else
+			mFlags[slot] &= ~flag;
+	}
+
+	// 모든 칸을 한 틱 진행. Alive 와 Simulating 이 둘다 켜진 칸만 바뀜.
+	// 높이, 거리, 거리당 HP 감소. 스턴/보호는 방의 타이머가 플래그만 켜고 끔.
+	// 죽음 처리는 방이 결과를 보고 함.
+	void Step(float dt, float drainPerTick);
+
+private:
+	void StepScalar(int begin, int end, float dt, float drainPerTick);
+	// 묶음 단위로 처리한 곳 다음 번호를 돌려줌.
+	int StepSse(int begin, int end, float dt, float drainPerTick);
+#ifdef __AVX2__
+	int StepAvx2(int begin, int end, float dt, float drainPerTick);
+#endif
+};
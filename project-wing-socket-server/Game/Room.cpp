@@ -0,0 +1,823 @@
+﻿#include "Game/Room.h"
+#include "Etc/DataStorageManager.h"
+#include "Network/MessageSender.h"
+#include "Network/SnapshotCodec.h"
+#include "Etc/TickScheduler.h"
+
+// 초를 틱 수로. 누적 시간이 기간을 넘는 첫 틱에 풀리던 예전 동작과 맞춤.
+static int SecondsToTicks(float seconds)
+{
+	return (int)(seconds * TICK_RATE) + 1;
+}
+
+EObstacleMode::Type CRoom::mObstacleMode = EObstacleMode::ClientSeeded;
+std::atomic<unsigned int> CRoom::mNextSnapshotSeq{ 1 };
+bool CRoom::mIsDeadReckoning = false;
+
+CRoom::CRoom()
+{
+
+}
+
+CRoom::~CRoom()
+{
+
+}
+
+void CRoom::Reset(int id)
+{
+	mId = id;
+	mClients.clear();
+	mDeadPlayers.clear();
+	mState = WAITING;
+	mOwnerId = -1;
+	mMapId = 0;
+	mTicksSinceSnapshot = 0;
+	mCurCountDownTime = 0.0f;
+	mIsFinishCountDown = false;
+	mTick = 0;
+	mTimers.Reset(0);
+	mCourseSeed = 0;
+	mTimeline = nullptr;
+	mSimTransit.clear();
+
+	for (auto& baseline : mBaselines)
+		baseline.seq = 0;
+	mBaselineHead = 0;
+}
+
+void CRoom::Broadcast(int senderId, int msgType, const void* data, int len)
+{
+	FramePtr frame = MakeFrame(senderId, msgType, data, len);
+
+	for (auto& c : mClients)
+		CMessageSender::GetInst()->Send(c->conn, frame);
+}
+
+void CRoom::AddClient(Client* client)
+{
+	client->Init();
+	client->room = this;
+	mClients.push_back(client);
+
+	if (mOwnerId == -1)
+		mOwnerId = client->id;
+
+	std::cout << "[Room " << mId << "] join client_" << client->id << " (" << mClients.size() << "/" << MAX_PLAYERS << ")\n";
+
+	CMessageSender::GetInst()->Send<TServerSchema<ServerMessage::MSG_ROOM_JOINED>>(client->conn, 0, mId);
+	SendRoomFullInfo(client);
+
+	for (auto& other : mClients)
+	{
+		if (other->id != client->id)
+			CMessageSender::GetInst()->Send<TServerSchema<ServerMessage::MSG_JOIN>>(other->conn, client->id, client->id);
+	}
+}
+
+void CRoom::RemoveClient(Client* client)
+{
+	auto it = std::find(mClients.begin(), mClients.end(), client);
+	if (it == mClients.end())
+		return;
+
+	bool wasOwner = (client->id == mOwnerId);
+	RemoveSimSlot(client);
+	mClients.erase(it);
+	client->room = nullptr;
+
+	std::cout << "[Room " << mId << "] leave client_" << client->id << " (" << mClients.size() << "/" << MAX_PLAYERS << ")\n";
+
+	Broadcast<TServerSchema<ServerMessage::MSG_DISCONNECT>>(client->id, client->id);
+
+	if (mClients.empty())
+	{
+		mOwnerId = -1;
+		return;
+	}
+
+	if (wasOwner)
+	{
+		mOwnerId = mClients.front()->id;
+		Broadcast<TServerSchema<ServerMessage::MSG_NEW_OWNER>>(0, mOwnerId);
+	}
+
+	// 남은 사람이 다 죽어 있으면 여기서 게임을 끝내야 함.
+	if (mState == RUNNING)
+		CheckGameOver();
+}
+
+void CRoom::StartGame()
+{
+	// 샤드 스레드마다 따로 둬서 전역 rand() 를 안 씀. 0 은 시작 못함 표시라 건너뜀.
+	static thread_local std::mt19937 seedRandom(std::random_device{}());
+
+	mState = RUNNING;
+	mDeadPlayers.clear();
+	mIsFinishCountDown = false;
+	mCurCountDownTime = 0.0f;
+	mTick = 0;
+	mTicksSinceSnapshot = 0;
+
+	do
+	{
+		mCourseSeed = seedRandom();
+	} while (mCourseSeed == 0);
+
+	std::cout << "[Room " << mId << "] course seed " << mCourseSeed << "\n";
+
+	mTimeline = CCollisionManager::GetInst()->FindTimeline(mMapId);
+	mTimers.Reset(0);
+	mProtectionTicks = SecondsToTicks(CDataStorageManager::GetInst()->GetConfig().ProtectionDuration);
+	mReckonHeightError = CDataStorageManager::GetInst()->GetConfig().DeadReckoningHeightError;
+	mReckonDistanceError = CDataStorageManager::GetInst()->GetConfig().DeadReckoningDistanceError;
+
+	for (auto& c : mClients)
+	{
+		c->isAlive = true;
+		c->nextObstacleStep = 1;
+		c->collisionStep = -1;
+		c->reckonState = FPackedPlayerState();
+		c->history.Clear();
+
+		// 스탯 계산해서 Init 하기.
+		// 테이블 읽어서 기본 스텟 초기화.
+		auto _statInfo = CDataStorageManager::GetInst()->GetCharacterState(c->characterId);
+		c->collisionHalfHeight = _statInfo.SizeY * 0.5f;
+
+		std::cout << "client_" << c->id
+			<< " _statInfo.HP: " << _statInfo.HP
+			<< " _statInfo.Speed: " << _statInfo.Speed
+			<< " _statInfo.Dex: " << _statInfo.Dex
+			<< " _statInfo.Def: " << _statInfo.Def
+			<< "\n";
+
+		c->InitStat(_statInfo);
+
+		std::cout << "client_" << c->id
+			<< " c->GetHP: " << c->GetCurHP()
+			<< " c->GetSpeed: " << c->GetSpeed()
+			<< " c->GetDex: " << c->GetDex()
+			<< " c->GetDef: " << c->GetDef()
+			<< "\n";
+
+		// 착용한 아이템 스텟에 적용.
+		auto _itemDatas = CDataStorageManager::GetInst()->GetItemInfoDatas();
+		int _itemLength = sizeof(c->itemSlots) / sizeof(c->itemSlots[0]);
+		for (int i = 0; i < _itemLength; i++)
+		{
+			int _itemIndexInSlot = c->itemSlots[i];
+			if (_itemIndexInSlot >= 0)
+			{
+				// 어떤 스탯에 얼마를 적용할것인지.
+				c->AddValueByStatIndex(
+					static_cast<EStatInfo::Type>(_itemDatas[_itemIndexInSlot].StatType)
+					, _itemDatas[_itemIndexInSlot].AddValue);
+			}
+		}
+
+		// 게임중에 바뀌는 값은 샤드 배열로 옮겨서 돌림. 카운트다운 끝날때까지는 멈춰 있음.
+		FPlayerSimRow row;
+		row.height = PLAYER_INIT_POS_HEIGHT;
+		row.hp = c->GetCurHP();
+		row.dex = c->GetDex();
+		row.speed = c->GetSpeed();
+		row.def = c->GetDef();
+		row.flags = EPlayerSimFlag::Alive;
+		mSim->Add(c, row);
+	}
+}
+
+void CRoom::RemoveSimSlot(Client* client)
+{
+	if (client->simSlot >= 0)
+		mSim->Remove(client->simSlot);
+}
+
+void CRoom::AttachSim(CPlayerSim* sim)
+{
+	mSim = sim;
+
+	if (mSimTransit.empty())
+		return;
+
+	for (size_t i = 0; i < mClients.size(); i++)
+		mSim->Add(mClients[i], mSimTransit[i]);
+
+	mSimTransit.clear();
+}
+
+void CRoom::DetachSim()
+{
+	mSimTransit.clear();
+
+	if (mState == RUNNING)
+	{
+		for (auto& c : mClients)
+			mSimTransit.push_back(mSim->Remove(c->simSlot));
+	}
+
+	mSim = nullptr;
+}
+
+void CRoom::KillPlayer(Client* client)
+{
+	client->isAlive = false;
+	mSim->SetFlag(client->simSlot, EPlayerSimFlag::Alive, false);
+	mDeadPlayers.insert(client->id);
+	Broadcast(client->id, (int)ServerMessage::MSG_PLAYER_DEAD, nullptr, 0);
+	CheckGameOver();
+}
+
+// 다 죽었으면 대기실로 되돌려서 방을 다시 씀.
+void CRoom::CheckGameOver()
+{
+	int aliveCount = 0;
+
+	for (auto& c : mClients)
+	{
+		if (c->isAlive)
+			aliveCount++;
+	}
+
+	if (aliveCount == 0)
+	{
+		for (auto& c : mClients)
+		{
+			RemoveSimSlot(c);
+			auto _statInfo = CDataStorageManager::GetInst()->GetCharacterState(c->characterId);
+			c->InitStat(_statInfo);
+			c->Init();
+		}
+		mMapId = 0;
+		mState = WAITING;
+		mTimers.Reset(0);
+		const char* msg = "All players dead. Game over.";
+		Broadcast(0, (int)ServerMessage::MSG_GAME_OVER, msg, strlen(msg) + 1);
+	}
+}
+
+void CRoom::SendRoomFullInfo(Client* client)
+{
+	RoomFullInfoHeader header{ mOwnerId, mMapId, (int)mClients.size() };
+	RoomPlayerInfo players[MAX_PLAYERS];
+
+	for (int i = 0; i < header.playerCount; i++)
+	{
+		Client* c = mClients[i];
+		players[i].id = c->id;
+		players[i].isReady = c->isReady;
+		players[i].characterId = c->characterId;
+		memcpy(players[i].itemSlots, c->itemSlots, sizeof(players[i].itemSlots));
+	}
+
+	std::vector<char> buffer;
+	EncodeArrayBody<TServerSchema<ServerMessage::MSG_ROOM_FULL_INFO>>(buffer, header, players, header.playerCount);
+	CMessageSender::GetInst()->Send(client->conn, 0, (int)ServerMessage::MSG_ROOM_FULL_INFO, buffer.data(), (int)buffer.size());
+}
+
+// 거리/높이/HP 를 플레이어마다 따로 뿌리던걸 틱당 메시지 하나로 합침.
+// 죽은 캐릭이라도 계속 보내야 함.
+// v4 클라는 ack 한 스냅샷 기준 델타, v3 클라는 비트로 줄인 판, 나머지는 예전 판.
+// 받는 클라가 있는 판만 한번씩 인코딩함.
+void CRoom::BroadcastWorldSnapshot()
+{
+	mSnapshotPlayers.clear();
+	mDeltaFrames.clear();
+
+	for (auto& c : mClients)
+	{
+		int slot = c->simSlot;
+
+		PlayerSnapshot player;
+		player.id = c->id;
+		player.distance = mSim->GetDistance(slot);
+		player.height = mSim->GetHeight(slot);
+		player.hp = mSim->GetHp(slot);
+		player.flags = 0;
+
+		if (c->isAlive) player.flags |= EPlayerSnapshotFlag::Alive;
+		if (mSim->HasFlag(slot, EPlayerSimFlag::Stun)) player.flags |= EPlayerSnapshotFlag::Stun;
+		if (mSim->HasFlag(slot, EPlayerSimFlag::Protection)) player.flags |= EPlayerSnapshotFlag::Protection;
+		if (mSim->IsBoost(slot)) player.flags |= EPlayerSnapshotFlag::Boost;
+		if (mSim->IsMovingUp(slot)) player.flags |= EPlayerSnapshotFlag::MovingUp;
+
+		mSnapshotPlayers.push_back(player);
+	}
+
+	bool hasDeltaClient = std::any_of(mClients.begin(), mClients.end(),
+		[](Client* c) { return c->protocolVersion >= PROTOCOL_VERSION_V4; });
+
+	if (hasDeltaClient)
+	{
+		// 0 은 기준 없음 표시라 건너뜀.
+		unsigned int seq = mNextSnapshotSeq++;
+		if (seq == 0)
+			seq = mNextSnapshotSeq++;
+
+		mCurrentBaseline.seq = seq;
+		mCurrentBaseline.count = (int)mSnapshotPlayers.size();
+
+		for (int i = 0; i < mCurrentBaseline.count; i++)
+			mCurrentBaseline.players[i] = PackReckonState(mClients[i], mSnapshotPlayers[i]);
+	}
+
+	FramePtr rawFrame;
+	FramePtr packedFrame;
+
+	for (auto& c : mClients)
+	{
+		if (c->protocolVersion >= PROTOCOL_VERSION_V4)
+		{
+			const FSnapshotBaseline* baseline = FindBaseline(c->snapshotAck);
+			unsigned int baselineSeq = baseline ? baseline->seq : 0;
+
+			auto iter = std::find_if(mDeltaFrames.begin(), mDeltaFrames.end(),
+				[baselineSeq](const std::pair<unsigned int, FramePtr>& entry) { return entry.first == baselineSeq; });
+
+			if (iter == mDeltaFrames.end())
+			{
+				mDeltaFrames.emplace_back(baselineSeq, EncodeDeltaSnapshot(baseline));
+				iter = mDeltaFrames.end() - 1;
+			}
+
+			CMessageSender::GetInst()->Send(c->conn, iter->second);
+		}
+		else if (c->protocolVersion >= PROTOCOL_VERSION_V3)
+		{
+			if (!packedFrame)
+				packedFrame = EncodePackedSnapshot();
+
+			CMessageSender::GetInst()->Send(c->conn, packedFrame);
+		}
+		else
+		{
+			if (!rawFrame)
+				rawFrame = EncodeRawSnapshot();
+
+			CMessageSender::GetInst()->Send(c->conn, rawFrame);
+		}
+	}
+
+	// 보낸 뒤에 기준 목록에 넣음. 제일 오래된 걸 덮어씀.
+	if (hasDeltaClient)
+	{
+		mBaselines[mBaselineHead] = mCurrentBaseline;
+		mBaselineHead = (mBaselineHead + 1) % SNAPSHOT_BASELINE_HISTORY;
+	}
+}
+
+// 이번 스냅샷에 실을 상태. 데드 레커닝이면 입력/스턴/부스트/죽음으로 플래그가 바뀌었거나
+// 클라가 늘려서 구할 값이 오차를 넘었을때만 높이/거리 기준점을 새로 찍음.
+FPackedPlayerState CRoom::PackReckonState(Client* client, const PlayerSnapshot& player)
+{
+	static_assert(SNAPSHOT_RECKON_TICK_RATE == TICK_RATE, "reckoning must use the server tick rate");
+	static_assert(SNAPSHOT_RECKON_BOOST == PLAYER_BOOST_MULTIPLIER, "reckoning must use the server boost multiplier");
+
+	int slot = client->simSlot;
+	FPackedPlayerState state = PackPlayerSnapshot(player, mTick, mSim->GetDex(slot), mSim->GetSpeed(slot));
+	const FPackedPlayerState& prev = client->reckonState;
+
+	bool isSameMotion = prev.id == state.id && prev.flags == state.flags
+		&& prev.dex == state.dex && prev.speed == state.speed;
+
+	if (mIsDeadReckoning && isSameMotion)
+	{
+		if (fabsf(ExtrapolateHeight(prev, mTick) - player.height) <= mReckonHeightError)
+		{
+			state.height = prev.height;
+			state.heightTick = prev.heightTick;
+		}
+
+		if (fabsf(ExtrapolateDistance(prev, mTick) - player.distance) <= mReckonDistanceError)
+		{
+			state.distance = prev.distance;
+			state.distanceTick = prev.distanceTick;
+		}
+	}
+
+	client->reckonState = state;
+	return state;
+}
+
+const FSnapshotBaseline* CRoom::FindBaseline(unsigned int seq) const
+{
+	if (seq == 0)
+		return nullptr;
+
+	for (auto& baseline : mBaselines)
+	{
+		if (baseline.seq == seq)
+			return &baseline;
+	}
+
+	return nullptr;
+}
+
+FramePtr CRoom::EncodeDeltaSnapshot(const FSnapshotBaseline* baseline)
+{
+	FDeltaSnapshotInfo info;
+	info.seq = mCurrentBaseline.seq;
+	info.baselineSeq = baseline ? baseline->seq : 0;
+	info.tick = mTick;
+	info.isReckoning = mIsDeadReckoning;
+
+	mSnapshotBuffer.clear();
+	WriteDeltaSnapshot(mSnapshotBuffer, info, mCurrentBaseline.players, mCurrentBaseline.count,
+		baseline ? baseline->players : nullptr, baseline ? baseline->count : 0);
+
+	return MakeFrame(0, (int)ServerMessage::MSG_WORLD_SNAPSHOT_DELTA, mSnapshotBuffer.data(), (int)mSnapshotBuffer.size());
+}
+
+FramePtr CRoom::EncodeRawSnapshot()
+{
+	int playerCount = (int)mSnapshotPlayers.size();
+	int totalSize = sizeof(WorldSnapshotHeader) + sizeof(PlayerSnapshot) * playerCount;
+	mSnapshotBuffer.resize(totalSize);
+
+	WorldSnapshotHeader header{ mTick, playerCount };
+	memcpy(mSnapshotBuffer.data(), &header, sizeof(header));
+	memcpy(mSnapshotBuffer.data() + sizeof(header), mSnapshotPlayers.data(), sizeof(PlayerSnapshot) * playerCount);
+
+	return MakeFrame(0, (int)ServerMessage::MSG_WORLD_SNAPSHOT, mSnapshotBuffer.data(), totalSize);
+}
+
+FramePtr CRoom::EncodePackedSnapshot()
+{
+	static_assert(MAX_PLAYERS < (1 << SNAPSHOT_PACKED_COUNT_BITS), "player count must fit");
+	static_assert(SNAPSHOT_HEIGHT_SPEC.maxValue == SCREEN_HEIGHT * 0.5f, "height spec must cover the screen");
+
+	mSnapshotBuffer.clear();
+	WritePackedSnapshot(mSnapshotBuffer, mTick, mSnapshotPlayers.data(), (int)mSnapshotPlayers.size());
+
+	return MakeFrame(0, (int)ServerMessage::MSG_WORLD_SNAPSHOT_PACKED, mSnapshotBuffer.data(), (int)mSnapshotBuffer.size());
+}
+
+void CRoom::CheckCollisions()
+{
+	if (!mTimeline)
+		return;
+
+	for (auto& c : mClients)
+	{
+		if (!c->isAlive || c->simSlot < 0)
+			continue;
+
+		int slot = c->simSlot;
+		float height = mSim->GetHeight(slot);
+		int step = GetObstacleStep(mSim->GetDistance(slot));
+		bool isObstacleHit = false;
+
+		// 칸이 바뀔때만 통로를 다시 읽고 그 칸 장애물을 한번 봄. 나머지 틱은 비교 두번.
+		if (step != c->collisionStep)
+		{
+			c->collisionStep = step;
+
+			const FCorridor& corridor = mTimeline->GetCorridor(step);
+			c->corridorMin = corridor.minHeight;
+			c->corridorMax = corridor.maxHeight;
+
+			if (step > 0)
+			{
+				Obstacle obs = MakeObstacle(mCourseSeed, step);
+				float reach = obs.scale * 0.5f + c->collisionHalfHeight;
+				isObstacleHit = std::abs(height - obs.height) < reach;
+			}
+		}
+
+		if (mSim->HasFlag(slot, EPlayerSimFlag::Stun) || mSim->HasFlag(slot, EPlayerSimFlag::Protection))
+			continue;
+
+		bool isOutside = height + c->collisionHalfHeight > c->corridorMax
+			|| height - c->collisionHalfHeight < c->corridorMin;
+
+		if (isObstacleHit || isOutside)
+			ApplyCollision(c);
+	}
+}
+
+void CRoom::ApplyCollision(Client* client)
+{
+	// 맵 테이블에 의한 데이지. 선택된 맵은 방마다 다름.
+	float _damage = CDataStorageManager::GetInst()->GetMapInfo(mMapId).CollisionDamage;
+	int slot = client->simSlot;
+	mSim->SetFlag(slot, EPlayerSimFlag::Stun, true);
+	mTimers.Schedule(SecondsToTicks(client->GetStunDuration()), ERoomTimer::StunEnd, client->id);
+	Broadcast(client->id, (int)ServerMessage::MSG_TAKEN_STUN, nullptr, 0);
+
+	// 방어력만큼 깎고 남은걸 HP 에서 뺌. 거리 데미지는 CPlayerSim::Step 에서 비율로 깎음.
+	float result = _damage - mSim->GetDef(slot);
+	result = result < 0.0f ? 0.0f : result;
+	mSim->SetHp(slot, mSim->GetHp(slot) - result);
+
+	TakenDamage packetHp{ client->id, mSim->GetHp(slot) };
+	Broadcast<TServerSchema<ServerMessage::MSG_TAKEN_DAMAGE>>(client->id, packetHp);
+
+	if (client->isAlive && mSim->GetHp(slot) <= 0.0f)
+	{
+		std::cout << "Collision Dead######## id: " << client->id << "\n";
+		KillPlayer(client);
+	}
+}
+
+void CRoom::OnTimer(const FTimer& timer)
+{
+	// 그 사이 나갔거나 게임이 끝났으면 무시.
+	auto it = std::find_if(mClients.begin(), mClients.end(),
+		[&timer](Client* c) { return c->id == timer.targetId; });
+
+	if (it == mClients.end() || (*it)->simSlot < 0)
+		return;
+
+	int slot = (*it)->simSlot;
+
+	switch ((ERoomTimer::Type)timer.type)
+	{
+	case ERoomTimer::StunEnd:
+		mSim->SetFlag(slot, EPlayerSimFlag::Stun, false);
+		mSim->SetFlag(slot, EPlayerSimFlag::Protection, true);
+		mTimers.Schedule(mProtectionTicks, ERoomTimer::ProtectionEnd, timer.targetId);
+		break;
+
+	case ERoomTimer::ProtectionEnd:
+		mSim->SetFlag(slot, EPlayerSimFlag::Protection, false);
+		break;
+	}
+}
+
+void CRoom::RecordHistory()
+{
+	for (auto& c : mClients)
+	{
+		if (c->simSlot < 0)
+			continue;
+
+		const FPlayerSimRow row = mSim->Read(c->simSlot);
+		c->history.Push(mTick, FPlayerHistoryFrame{ row.height, row.distance, row.flags });
+	}
+}
+
+bool CRoom::ValidateCollisionReport(Client* client, const CollisionReport* report)
+{
+	// 오차. 클라 보간/렌더 차이만큼 봐줌.
+	const float heightTolerance = 20.0f;
+	const int stepTolerance = 1;
+
+	FPlayerHistoryFrame frame;
+
+	if (report)
+	{
+		// 너무 오래됐거나 아직 안 온 틱.
+		if (!client->history.Find(report->tick, frame))
+			return false;
+	}
+	else if (!client->history.GetLatest(frame))
+	{
+		return false;
+	}
+
+	// 그때 이미 스턴이나 무적이었으면 박을 수 없음.
+	if (!(frame.flags & EPlayerSimFlag::Alive)
+		|| (frame.flags & (EPlayerSimFlag::Stun | EPlayerSimFlag::Protection)))
+		return false;
+
+	int frameStep = GetObstacleStep(frame.distance);
+	int step = report ? report->step : frameStep;
+
+	if (step <= 0 || std::abs(step - frameStep) > stepTolerance)
+		return false;
+
+	Obstacle obs = MakeObstacle(mCourseSeed, step);
+	float reach = obs.scale * 0.5f + client->collisionHalfHeight + heightTolerance;
+
+	return std::abs(frame.height - obs.height) <= reach;
+}
+
+void CRoom::StreamObstacles(Client* client)
+{
+	int currentStep = client->simSlot >= 0 ? GetObstacleStep(mSim->GetDistance(client->simSlot)) : 0;
+
+	if (currentStep + OBSTACLE_REFILL_MARGIN < client->nextObstacleStep)
+		return;
+
+	// 한 틱에 여러 칸을 건너뛰었어도 빈칸 없이 이어서 보냄.
+	int lastStep = currentStep + OBSTACLE_LOOKAHEAD_STEPS;
+	int count = lastStep - client->nextObstacleStep + 1;
+
+	char buffer[sizeof(ObstacleBatchHeader) + sizeof(Obstacle) * (OBSTACLE_LOOKAHEAD_STEPS + OBSTACLE_REFILL_MARGIN + 1)];
+	count = std::min(count, (int)((sizeof(buffer) - sizeof(ObstacleBatchHeader)) / sizeof(Obstacle)));
+
+	ObstacleBatchHeader header{ client->nextObstacleStep, count };
+	memcpy(buffer, &header, sizeof(header));
+
+	Obstacle* obstacles = (Obstacle*)(buffer + sizeof(header));
+	for (int i = 0; i < count; i++)
+		obstacles[i] = MakeObstacle(mCourseSeed, header.firstStep + i);
+
+	client->nextObstacleStep += count;
+
+	int len = (int)(sizeof(header) + sizeof(Obstacle) * count);
+	CMessageSender::GetInst()->Send(client->conn, client->id, ServerMessage::MSG_OBSTACLE_BATCH, buffer, len);
+}
+
+void CRoom::BeginTick(float dt)
+{
+	const float countDownTime = 5.0f;
+
+	if (mState != RUNNING)
+		return;
+
+	mTicksSinceSnapshot++;
+
+	// 카운트다운 처리
+	if (!mIsFinishCountDown)
+	{
+		mCurCountDownTime += dt;
+
+		if (mCurCountDownTime < countDownTime)
+			return;
+		else
+		{
+			mIsFinishCountDown = true;
+			mCurCountDownTime = 0.0f;
+			Broadcast(0, (int)ServerMessage::MSG_COUNTDOWN_FINISHED, nullptr, 0);
+
+			// 이번 틱부터 샤드가 움직여 줌.
+			for (auto& c : mClients)
+				mSim->SetFlag(c->simSlot, EPlayerSimFlag::Simulating, true);
+		}
+	}
+
+	mTick++;
+
+	// 이번 틱에 끝나는 스턴/무적을 먼저 풀어서 예전처럼 풀린 틱부터 움직임.
+	mTimers.Advance(mTick, [this](const FTimer& timer) { OnTimer(timer); });
+}
+
+void CRoom::EndTick()
+{
+	if (mState != RUNNING || !mIsFinishCountDown)
+		return;
+
+	CheckCollisions();
+
+	if (mState != RUNNING)
+		return;
+
+	// 이동/HP 는 CPlayerSim::Step 에서 끝났음. 여기선 결과만 보고 죽음 처리.
+	for (auto& c : mClients)
+	{
+		if (!c->isAlive || c->simSlot < 0)
+			continue;
+
+		if (mSim->GetHp(c->simSlot) <= 0.0f)
+		{
+			std::cout << "DamagedPerDistance Dead id: " << c->id << "\n";
+			KillPlayer(c);
+		}
+	}
+
+	// 이번 틱에 게임이 끝났으면 더 진행하지 않음.
+	if (mState != RUNNING)
+		return;
+
+	if (mObstacleMode == EObstacleMode::ServerStreamed)
+	{
+		for (auto& c : mClients)
+		{
+			if (c->isAlive)
+				StreamObstacles(c);
+		}
+	}
+
+	RecordHistory();
+
+	// SNAPSHOT_TICK_INTERVAL 틱마다 전체 상태를 스냅샷 하나로 브로드캐스트
+	if (mTicksSinceSnapshot >= SNAPSHOT_TICK_INTERVAL)
+	{
+		mTicksSinceSnapshot = 0;
+		BroadcastWorldSnapshot();
+	}
+}
+
+// 방 안 메시지. server-main 의 처리 표에서 방에 있을때만 불림.
+// 바디 길이는 OnClientMessage 에서 스키마로 확인했음.
+void CRoom::OnStart(Client* client, const MessageHeader& header, const char* body)
+{
+	if (client->id != mOwnerId || mState != WAITING)
+		return;
+
+	bool allReady = std::all_of(mClients.begin(), mClients.end(),
+		[this](Client* c)
+		{
+			return (c->id == mOwnerId) || c->isReady;
+		});
+
+	if (allReady)
+		StartGame();
+
+	// 시작에 대한 결과를 알려줘야 함. 장애물은 클라가 시드로 직접 만듦.
+	// 서버가 장애물을 정하면 시드는 숨기고 카운트다운 동안 첫 묶음을 받게 함.
+	bool isSeedShared = allReady && mObstacleMode == EObstacleMode::ClientSeeded;
+	StartAck ack{ static_cast<int>(allReady), isSeedShared ? mCourseSeed : 0u };
+	Broadcast<TServerSchema<ServerMessage::MSG_START_ACK>>(client->id, ack);
+
+	if (allReady && mObstacleMode == EObstacleMode::ServerStreamed)
+	{
+		for (auto& c : mClients)
+			StreamObstacles(c);
+	}
+}
+
+void CRoom::OnReady(Client* client, const MessageHeader& header, const char* body)
+{
+	client->isReady = true;
+	Broadcast(client->id, (int)ServerMessage::MSG_READY, nullptr, 0);
+}
+
+void CRoom::OnUnready(Client* client, const MessageHeader& header, const char* body)
+{
+	client->isReady = false;
+	Broadcast(client->id, (int)ServerMessage::MSG_UNREADY, nullptr, 0);
+}
+
+void CRoom::OnPickCharacter(Client* client, const MessageHeader& header, const char* body)
+{
+	DecodeBody<TClientSchema<ClientMessage::MSG_PICK_CHARACTER>>(body, header.bodyLen, client->characterId);
+	Broadcast<TServerSchema<ServerMessage::MSG_PICK_CHARACTER>>(client->id, client->characterId);
+}
+
+void CRoom::OnPickItem(Client* client, const MessageHeader& header, const char* body)
+{
+	PickItem pick;
+	DecodeBody<TClientSchema<ClientMessage::MSG_PICK_ITEM>>(body, header.bodyLen, pick);
+	if (pick.slot >= 0 && pick.slot < 3) client->itemSlots[pick.slot] = pick.itemId;
+	Broadcast<TServerSchema<ServerMessage::MSG_PICK_ITEM>>(client->id, pick);
+}
+
+void CRoom::OnPickMap(Client* client, const MessageHeader& header, const char* body)
+{
+	if (client->id != mOwnerId)
+		return;
+
+	DecodeBody<TClientSchema<ClientMessage::MSG_PICK_MAP>>(body, header.bodyLen, mMapId);
+	Broadcast<TServerSchema<ServerMessage::MSG_PICK_MAP>>(0, mMapId);
+}
+
+void CRoom::OnMoveUp(Client* client, const MessageHeader& header, const char* body)
+{
+	if (client->simSlot >= 0)
+		mSim->SetMovingUp(client->simSlot, true);
+	Broadcast(client->id, (int)ServerMessage::MSG_MOVE_UP, nullptr, 0);
+}
+
+void CRoom::OnMoveDown(Client* client, const MessageHeader& header, const char* body)
+{
+	if (client->simSlot >= 0)
+		mSim->SetMovingUp(client->simSlot, false);
+	Broadcast(client->id, (int)ServerMessage::MSG_MOVE_DOWN, nullptr, 0);
+}
+
+void CRoom::OnTakeDamage(Client* client, const MessageHeader& header, const char* body)
+{
+	// 통로 정보가 있는 맵은 서버가 직접 판정하므로 클라 신고는 무시함.
+	if (mState != RUNNING || mTimeline || !client->isAlive || client->simSlot < 0)
+		return;
+
+	// 스턴/무적 중이면 이미 처리한 충돌을 또 보낸 것.
+	if (mSim->HasFlag(client->simSlot, EPlayerSimFlag::Stun)
+		|| mSim->HasFlag(client->simSlot, EPlayerSimFlag::Protection))
+		return;
+
+	CollisionReport report;
+	const CollisionReport* reportPtr = nullptr;
+
+	// 예전 float 바디면 크기가 달라서 안 꺼내짐.
+	if (DecodeBody<TClientSchema<ClientMessage::MSG_TAKE_DAMAGE>>(body, header.bodyLen, report))
+		reportPtr = &report;
+
+	if (!ValidateCollisionReport(client, reportPtr))
+	{
+		mRejectedReports++;
+		std::cout << "[Room " << mId << "] rejected collision report client_" << client->id
+			<< " (total " << mRejectedReports << ")\n";
+		return;
+	}
+
+	std::cout << "ClientMessage::MSG_TAKE_DAMAGE id: " << client->id << "\n";
+	ApplyCollision(client);
+}
+
+void CRoom::OnBoostOn(Client* client, const MessageHeader& header, const char* body)
+{
+	if (client->simSlot >= 0)
+		mSim->SetBoost(client->simSlot, true);
+	Broadcast(client->id, (int)ServerMessage::MSG_BOOST_ON, nullptr, 0);
+}
+
+void CRoom::OnBoostOff(Client* client, const MessageHeader& header, const char* body)
+{
+	if (client->simSlot >= 0)
+		mSim->SetBoost(client->simSlot, false);
+	Broadcast(client->id, (int)ServerMessage::MSG_BOOST_OFF, nullptr, 0);
+}
@@ -0,0 +1,190 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Game/Client.h"
+#include "Game/PlayerSim.h"
+#include "Game/ObstacleCourse.h"
+#include "Game/CollisionManager.h"
+#include "Etc/TimerWheel.h"
+#include "Network/Protocol.h"
+
+// 방 하나 정원.
+#define MAX_PLAYERS 5
+
+#define SCREEN_WIDTH 1280.0f
+#define SCREEN_HEIGHT 720.0f
+
+// 스냅샷은 이 틱 수마다 한번. TICK_RATE 60 기준 30Hz.
+#define SNAPSHOT_TICK_INTERVAL 2
+
+// 델타 스냅샷의 기준으로 남겨두는 최근 스냅샷 수. 30Hz 기준 약 1초.
+// 클라 ack 가 이보다 늦으면 기준 없이 전부 보냄.
+#define SNAPSHOT_BASELINE_HISTORY 32
+
+// 높이 가운데서부터 시작 함.
+#define PLAYER_INIT_POS_HEIGHT 0.0f
+
+enum GameState { WAITING, RUNNING };
+
+// 방 타이머 휠에 거는 타이머 종류. targetId 는 클라 id.
+namespace ERoomTimer
+{
+	enum Type
+	{
+		StunEnd,
+		ProtectionEnd
+	};
+}
+
+// 델타 스냅샷 기준 하나. seq 는 모든 방이 같이 쓰는 번호라 다른 방 ack 와 안 겹침.
+struct FSnapshotBaseline
+{
+	unsigned int seq = 0;
+	int count = 0;
+	FPackedPlayerState players[MAX_PLAYERS];
+};
+
+// 방 하나의 대기실 + 인게임 상태.
+// 예전에 전역으로 하나만 있던 상태를 방마다 따로 들고 있음.
+// 방을 가진 샤드 스레드에서만 건드림.
+class CRoom
+{
+private:
+	int mId = 0;
+
+	std::vector<Client*> mClients;
+	std::unordered_set<int> mDeadPlayers;
+
+	GameState mState = WAITING;
+	int mOwnerId = -1;
+	int mMapId = 0;
+
+	int mTicksSinceSnapshot = 0;
+	float mCurCountDownTime = 0.0f;
+	bool mIsFinishCountDown = false;
+	// 카운트다운이 끝난 뒤 지난 틱 수. 스냅샷과 플레이어 기록에 같이 붙음.
+	int mTick = 0;
+
+	// 이번 판 장애물 코스 시드. 게임 시작마다 새로 뽑음.
+	unsigned int mCourseSeed = 0;
+
+	// 이번 판 맵의 통로. 라인 노드가 없는 맵이면 nullptr 이고 그때만 클라 충돌 신고를 받음.
+	const FCollisionTimeline* mTimeline = nullptr;
+
+	int mRejectedReports = 0;
+
+	// 스턴/무적 해제 같은 게임 타이머. 방 틱 (mTick) 기준.
+	CTimerWheel mTimers;
+	int mProtectionTicks = 0;
+
+	// 모든 방 공통. 서버 시작할때 한번 정함.
+	static EObstacleMode::Type mObstacleMode;
+
+	// 켜져 있으면 클라가 늘려서 구한 높이/거리가 오차 안이면 다시 안 보냄. 델타 스냅샷에만.
+	// 높이는 픽셀, 거리는 맵 거리 단위라 오차도 따로 둠.
+	static bool mIsDeadReckoning;
+	float mReckonHeightError = 0.0f;
+	float mReckonDistanceError = 0.0f;
+
+	std::vector<char> mSnapshotBuffer;
+	std::vector<PlayerSnapshot> mSnapshotPlayers;
+
+	// v4 클라가 있을때만 채움. mBaselines 는 돌려쓰는 고정 배열.
+	FSnapshotBaseline mCurrentBaseline;
+	FSnapshotBaseline mBaselines[SNAPSHOT_BASELINE_HISTORY];
+	int mBaselineHead = 0;
+	// 이번 스냅샷에서 기준 번호별로 만든 프레임. 기준이 같은 클라끼리 나눠 씀.
+	std::vector<std::pair<unsigned int, FramePtr>> mDeltaFrames;
+	static std::atomic<unsigned int> mNextSnapshotSeq;
+
+	// 방을 가진 샤드의 플레이어 상태 배열. 게임중인 클라는 여기 칸을 하나씩 가짐.
+	CPlayerSim* mSim = nullptr;
+
+	// 샤드 사이로 옮기는 동안 떼어낸 칸들. mClients 순서와 같음.
+	std::vector<FPlayerSimRow> mSimTransit;
+
+public:
+	CRoom();
+	~CRoom();
+
+	static void SetObstacleMode(EObstacleMode::Type mode) { mObstacleMode = mode; }
+	static void SetDeadReckoning(bool isOn) { mIsDeadReckoning = isOn; }
+
+	// 풀에서 꺼내 쓸때 새 번호로 초기화.
+	void Reset(int id);
+
+	inline int GetId() const { return mId; }
+	inline GameState GetState() const { return mState; }
+	inline int GetMapId() const { return mMapId; }
+	inline int GetPlayerCount() const { return (int)mClients.size(); }
+	inline const std::vector<Client*>& GetClients() const { return mClients; }
+	inline int GetScheduledTimerCount() const { return mTimers.GetCount(); }
+	inline bool IsEmpty() const { return mClients.empty(); }
+	inline bool IsFull() const { return (int)mClients.size() >= MAX_PLAYERS; }
+
+	// 대기중이고 자리가 있어야 들어올 수 있음.
+	inline bool IsJoinable() const { return mState == WAITING && !IsFull(); }
+
+	void AddClient(Client* client);
+	void RemoveClient(Client* client);
+
+	// 방 안에서만 의미있는 메시지 처리. server-main 의 클라 메시지 처리 표에 하나씩 들어감.
+	void OnStart(Client* client, const MessageHeader& header, const char* body);
+	void OnReady(Client* client, const MessageHeader& header, const char* body);
+	void OnUnready(Client* client, const MessageHeader& header, const char* body);
+	void OnPickCharacter(Client* client, const MessageHeader& header, const char* body);
+	void OnPickItem(Client* client, const MessageHeader& header, const char* body);
+	void OnPickMap(Client* client, const MessageHeader& header, const char* body);
+	void OnMoveUp(Client* client, const MessageHeader& header, const char* body);
+	void OnMoveDown(Client* client, const MessageHeader& header, const char* body);
+	void OnTakeDamage(Client* client, const MessageHeader& header, const char* body);
+	void OnBoostOn(Client* client, const MessageHeader& header, const char* body);
+	void OnBoostOff(Client* client, const MessageHeader& header, const char* body);
+
+	// 샤드에 붙을때 그 샤드의 CPlayerSim 을 받음. 옮기던 칸이 있으면 다시 넣음.
+	void AttachSim(CPlayerSim* sim);
+
+	// 샤드에서 떨어질때 칸들을 값으로 떼어 들고 있음.
+	void DetachSim();
+
+	// 한 틱 진행. dt 는 항상 고정 틱 간격.
+	// 플레이어 이동/HP 는 샤드가 CPlayerSim::Step 으로 한번에 돌리고,
+	// BeginTick 은 그 전에 카운트다운과 타이머, EndTick 은 그 뒤에 죽음/스냅샷을 처리함.
+	void BeginTick(float dt);
+	void EndTick();
+
+	// 프레임은 한번만 인코딩하고 모든 수신자 큐에 같은 프레임을 넣음.
+	void Broadcast(int senderId, int msgType, const void* data, int len);
+
+	// 고정 크기 바디. 메시지 번호와 바디 타입은 스키마에서.
+	template<typename Schema>
+	void Broadcast(int senderId, const typename Schema::Body& body)
+	{
+		Broadcast(senderId, (int)Schema::Type, &body, (int)sizeof(body));
+	}
+
+private:
+	void StartGame();
+	void CheckGameOver();
+	void KillPlayer(Client* client);
+
+	// 통로 밖이나 이번 칸 장애물에 걸린 플레이어를 찾아서 충돌 처리.
+	void CheckCollisions();
+	void ApplyCollision(Client* client);
+	void OnTimer(const FTimer& timer);
+
+	// 클라 충돌 신고를 클라가 보던 틱의 기록으로 확인. 그때 그 자리에서 박을 수 없었으면 false.
+	bool ValidateCollisionReport(Client* client, const CollisionReport* report);
+	void RecordHistory();
+	void RemoveSimSlot(Client* client);
+	void SendRoomFullInfo(Client* client);
+	void BroadcastWorldSnapshot();
+	FramePtr EncodeRawSnapshot();
+	FramePtr EncodePackedSnapshot();
+	FramePtr EncodeDeltaSnapshot(const FSnapshotBaseline* baseline);
+	FPackedPlayerState PackReckonState(Client* client, const PlayerSnapshot& player);
+	const FSnapshotBaseline* FindBaseline(unsigned int seq) const;
+
+	// 클라가 OBSTACLE_REFILL_MARGIN 안쪽까지 왔으면 다음 OBSTACLE_LOOKAHEAD_STEPS 칸을 한 메시지로.
+	void StreamObstacles(Client* client);
+};
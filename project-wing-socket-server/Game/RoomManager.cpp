@@ -0,0 +1,228 @@
+﻿#include "Game/RoomManager.h"
+#include "Game/ShardManager.h"
+#include "Network/MessageSender.h"
+
+CRoomManager::CRoomManager()
+{
+
+}
+
+CRoomManager::~CRoomManager()
+{
+	for (auto& room : mRooms)
+		delete room;
+
+	for (auto& room : mFreeRooms)
+		delete room;
+}
+
+CRoom* CRoomManager::CreateRoom()
+{
+	int roomId = CShardManager::GetInst()->RegisterRoom(mShardIndex);
+	if (roomId == 0)
+		return nullptr;
+
+	CRoom* room = nullptr;
+
+	if (!mFreeRooms.empty())
+	{
+		room = mFreeRooms.back();
+		mFreeRooms.pop_back();
+	}
+	else
+	{
+		room = new CRoom;
+	}
+
+	room->Reset(roomId);
+	room->AttachSim(&mSim);
+	mRooms.push_back(room);
+
+	std::cout << "[Room " << room->GetId() << "] created on shard " << mShardIndex << "\n";
+	return room;
+}
+
+CRoom* CRoomManager::FindRoom(int roomId)
+{
+	for (auto& room : mRooms)
+	{
+		if (room->GetId() == roomId)
+			return room;
+	}
+
+	return nullptr;
+}
+
+CRoom* CRoomManager::FindJoinableRoom()
+{
+	for (auto& room : mRooms)
+	{
+		if (room->IsJoinable())
+			return room;
+	}
+
+	return nullptr;
+}
+
+void CRoomManager::JoinRoom(Client* client, CRoom* room)
+{
+	if (client->room == room)
+		return;
+
+	if (client->room)
+		LeaveRoom(client);
+
+	room->AddClient(client);
+}
+
+void CRoomManager::LeaveRoom(Client* client)
+{
+	CRoom* room = client->room;
+	if (!room)
+		return;
+
+	room->RemoveClient(client);
+
+	if (room->IsEmpty())
+		ReleaseRoom(room);
+}
+
+void CRoomManager::ReleaseRoom(CRoom* room)
+{
+	auto it = std::find(mRooms.begin(), mRooms.end(), room);
+	if (it == mRooms.end())
+		return;
+
+	std::cout << "[Room " << room->GetId() << "] released\n";
+
+	CShardManager::GetInst()->UnregisterRoom(room->GetId());
+	mRooms.erase(it);
+	mFreeRooms.push_back(room);
+}
+
+void CRoomManager::SendRoomList(Client* client)
+{
+	std::vector<RoomSummary> rooms;
+	CollectRoomList(rooms);
+	CShardManager::GetInst()->CollectRoomList(rooms, mShardIndex);
+
+	std::vector<char> buffer;
+	RoomListHeader header{ (int)rooms.size() };
+	EncodeArrayBody<TServerSchema<ServerMessage::MSG_ROOM_LIST>>(buffer, header, rooms.data(), header.roomCount);
+
+	CMessageSender::GetInst()->Send(client->conn, 0, (int)ServerMessage::MSG_ROOM_LIST, buffer.data(), (int)buffer.size());
+}
+
+void CRoomManager::CollectRoomList(std::vector<RoomSummary>& outRooms) const
+{
+	for (auto& room : mRooms)
+		outRooms.push_back({ room->GetId(), room->GetPlayerCount(), MAX_PLAYERS, (int)room->GetState(), room->GetMapId() });
+}
+
+void CRoomManager::SendReject(Client* client, const char* reason)
+{
+	CMessageSender::GetInst()->Send(client->conn, 0, (int)ServerMessage::MSG_ROOM_REJECT, reason, (int)strlen(reason) + 1);
+}
+
+void CRoomManager::Update(float dt)
+{
+	for (auto& room : mRooms)
+	{
+		if (room->GetState() == RUNNING)
+			room->BeginTick(dt);
+	}
+
+#ifdef _DEBUG
+	mSim.Step(dt, dt * 10.0f);
+#else
+	mSim.Step(dt, dt);
+#endif
+
+	for (auto& room : mRooms)
+	{
+		if (room->GetState() == RUNNING)
+			room->EndTick();
+	}
+}
+
+int CRoomManager::GetRunningRoomCount() const
+{
+	int count = 0;
+
+	for (auto& room : mRooms)
+	{
+		if (room->GetState() == RUNNING)
+			count++;
+	}
+
+	return count;
+}
+
+int CRoomManager::GetScheduledTimerCount() const
+{
+	int count = 0;
+
+	for (auto& room : mRooms)
+		count += room->GetScheduledTimerCount();
+
+	return count;
+}
+
+CRoom* CRoomManager::PickRoomToMigrate(int loadPermille, int targetLoadPermille) const
+{
+	int runningPlayers = 0;
+
+	for (auto& room : mRooms)
+	{
+		if (room->GetState() == RUNNING)
+			runningPlayers += room->GetPlayerCount();
+	}
+
+	if (runningPlayers == 0)
+		return nullptr;
+
+	CRoom* best = nullptr;
+
+	for (auto& room : mRooms)
+	{
+		if (room->GetState() != RUNNING)
+			continue;
+
+		int share = loadPermille * room->GetPlayerCount() / runningPlayers;
+
+		// 받는 쪽이 더 바빠지면 옮겨도 소용없음.
+		if (targetLoadPermille + share >= loadPermille - share)
+			continue;
+
+		if (!best || room->GetPlayerCount() > best->GetPlayerCount())
+			best = room;
+	}
+
+	return best;
+}
+
+void CRoomManager::DetachRoom(CRoom* room)
+{
+	auto it = std::find(mRooms.begin(), mRooms.end(), room);
+	if (it != mRooms.end())
+		mRooms.erase(it);
+
+	room->DetachSim();
+}
+
+void CRoomManager::AttachRoom(CRoom* room)
+{
+	room->AttachSim(&mSim);
+	mRooms.push_back(room);
+}
+
+bool CRoomManager::HasRunningRoom() const
+{
+	for (auto& room : mRooms)
+	{
+		if (room->GetState() == RUNNING)
+			return true;
+	}
+
+	return false;
+}
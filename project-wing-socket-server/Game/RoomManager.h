@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Game/Room.h"
+
+// 한 프로세스에서 동시에 여는 최대 방 수. 모든 샤드를 합친 값.
+#define MAX_ROOMS 64
+
+// 샤드 하나의 방 목록과 로비 처리. 빈 방은 풀에 돌려놨다가 다시 씀.
+// 방 번호는 샤드 매니저의 방 목록에 등록해서 받으므로 프로세스 전체에서 겹치지 않음.
+// 샤드마다 하나씩 가지고 그 샤드 스레드에서만 건드림.
+class CRoomManager
+{
+private:
+	std::vector<CRoom*> mRooms;
+	std::vector<CRoom*> mFreeRooms;
+	int mShardIndex = 0;
+
+	// 이 샤드 방들의 게임중인 플레이어 전부.
+	CPlayerSim mSim;
+
+public:
+	CRoomManager();
+	~CRoomManager();
+
+	inline void SetShardIndex(int shardIndex) { mShardIndex = shardIndex; }
+
+	// 프로세스 전체 방 자리가 없으면 nullptr.
+	CRoom* CreateRoom();
+	CRoom* FindRoom(int roomId);
+
+	// 이 샤드에서 대기중이고 자리가 있는 방. 없으면 nullptr.
+	CRoom* FindJoinableRoom();
+
+	// 방에 넣음. 다른 방에 있었으면 거기서 먼저 뺌.
+	void JoinRoom(Client* client, CRoom* room);
+
+	// 방에서 빼고 빈 방이면 풀로 돌려놓음.
+	void LeaveRoom(Client* client);
+
+	// 이 샤드 방들은 지금 값으로, 다른 샤드 방들은 마지막으로 공개된 목록으로 보냄.
+	void SendRoomList(Client* client);
+	void CollectRoomList(std::vector<RoomSummary>& outRooms) const;
+	void SendReject(Client* client, const char* reason);
+
+	// 게임중인 방만 한 틱씩 진행. 플레이어는 방을 가리지 않고 한번에 갱신함.
+	void Update(float dt);
+	bool HasRunningRoom() const;
+	int GetRunningRoomCount() const;
+	int GetScheduledTimerCount() const;
+
+	inline int GetRoomCount() const { return (int)mRooms.size(); }
+
+	// 다른 샤드로 넘길 게임중인 방. 옮긴 뒤에도 이쪽이 더 바쁘게 남는 것 중 인원이 제일 많은 방.
+	// 사용률은 천분율이고, 방 하나의 몫은 이 샤드 사용률을 인원 비율로 나눠서 어림함.
+	CRoom* PickRoomToMigrate(int loadPermille, int targetLoadPermille) const;
+
+	// 방 번호와 클라는 그대로 두고 목록에서만 빼거나 넣음. 샤드 사이에 방을 옮길때 씀.
+	void DetachRoom(CRoom* room);
+	void AttachRoom(CRoom* room);
+
+private:
+	void ReleaseRoom(CRoom* room);
+};
@@ -0,0 +1,341 @@
+﻿#include "Game/Shard.h"
+#include "Game/ShardManager.h"
+#include "Game/Client.h"
+#include "Network/MessageSender.h"
+
+static thread_local CShard* tCurrentShard = nullptr;
+
+CShard::CShard()
+{
+
+}
+
+CShard::~CShard()
+{
+	if (mWakeEvent)
+		CloseHandle(mWakeEvent);
+}
+
+bool CShard::Init(int index)
+{
+	mIndex = index;
+	mRooms.SetShardIndex(index);
+	mPublishedRooms = std::make_shared<const std::vector<RoomSummary>>();
+
+	mWakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+	if (mWakeEvent == nullptr)
+		return false;
+
+	return mScheduler.Init("Shard " + std::to_string(index));
+}
+
+void CShard::Start()
+{
+	mThread = std::thread(&CShard::ThreadLoop, this);
+	mThread.detach();
+}
+
+CShard* CShard::GetCurrent()
+{
+	return tCurrentShard;
+}
+
+bool CShard::Post(const FShardCommand& command)
+{
+	CShard* sender = GetCurrent();
+
+	if (sender && sender != this)
+	{
+		sender->PostDeferred(this, command);
+		return true;
+	}
+
+	while (!TryPush(command))
+	{
+		// 입력은 곧 다음 값이 다시 오니까 버림. 접속/정리/이동은 잃으면 안 돼서 기다림.
+		// 여기서 기다리는건 I/O 나 메인 스레드라 샤드가 비우는걸 막지 않음.
+		if (command.type == EShardCommand::ClientMessage)
+		{
+			mDroppedCommands++;
+			return false;
+		}
+
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
+bool CShard::TryPush(const FShardCommand& command)
+{
+	if (!mCommands.Push(command))
+		return false;
+
+	if (!mIsWakePending.exchange(true))
+		SetEvent(mWakeEvent);
+
+	return true;
+}
+
+// 이 샤드 스레드에서 target 에 넣음. 먼저 쌓인게 있으면 순서를 지키려고 뒤에 붙임.
+// 넘겨받는 쪽 순서가 걸려 있어서 다시 넘기는 클라 메시지도 버리지 않음.
+void CShard::PostDeferred(CShard* target, const FShardCommand& command)
+{
+	if ((int)mOutbox.size() <= target->GetIndex())
+		mOutbox.resize(target->GetIndex() + 1);
+
+	std::deque<FShardCommand>& outbox = mOutbox[target->GetIndex()];
+
+	if (outbox.empty() && target->TryPush(command))
+		return;
+
+	outbox.push_back(command);
+	mDeferredCommands++;
+}
+
+// FlushHandoffs 뒤에 부름. 받는 샤드마다 앞에서부터 들어가는데까지 넣음.
+void CShard::FlushOutbox()
+{
+	bool isPending = false;
+
+	for (int i = 0; i < (int)mOutbox.size(); i++)
+	{
+		std::deque<FShardCommand>& outbox = mOutbox[i];
+		CShard* target = CShardManager::GetInst()->GetShard(i);
+
+		while (!outbox.empty() && target->TryPush(outbox.front()))
+			outbox.pop_front();
+
+		if (!outbox.empty())
+			isPending = true;
+	}
+
+	// 남은게 있으면 틱까지 자지 않고 바로 다시 시도함.
+	if (isPending && !mIsWakePending.exchange(true))
+		SetEvent(mWakeEvent);
+}
+
+void CShard::DrainCommands()
+{
+	// 꺼내기 전에 내려야 꺼내는 도중에 들어온 명령이 다음 깨우기를 놓치지 않음.
+	mIsWakePending = false;
+
+	FShardCommand command;
+
+	while (mCommands.Pop(command))
+	{
+		if (command.conn && HoldCommand(command))
+			continue;
+
+		switch (command.type)
+		{
+		case EShardCommand::AdoptRoom:
+			AdoptRoom((CRoom*)command.target);
+			break;
+
+		case EShardCommand::MigrateRoom:
+			MigrateRoomTo(CShardManager::GetInst()->GetShard(command.arg0), command.arg1);
+			break;
+
+		default:
+			CShardManager::GetInst()->Dispatch(this, command);
+			break;
+		}
+	}
+}
+
+// 넘겨받는 중인 연결 명령이면 쌓아두고 true.
+// HandoffDone 이면 옛 샤드에서 넘어온 것부터 쌓아둔 순서대로 처리함.
+bool CShard::HoldCommand(const FShardCommand& command)
+{
+	Connection* conn = command.conn;
+
+	if (command.type != EShardCommand::HandoffDone)
+	{
+		// 옛 샤드에 남은건 Dispatch 가 새 담당으로 넘기게 둠.
+		if (!conn->isHandingOff || conn->shardIndex != mIndex)
+			return false;
+
+		FHandoffHold& hold = mHandoffsIn[conn];
+
+		if (command.isForwarded)
+			hold.forwarded.push_back(command);
+		else
+			hold.direct.push_back(command);
+
+		return true;
+	}
+
+	conn->isHandingOff = false;
+
+	// 처리하다가 또 다른 샤드로 넘어가면 나머지는 Dispatch 가 따라 보냄.
+	auto iter = mHandoffsIn.find(conn);
+
+	if (iter != mHandoffsIn.end())
+	{
+		FHandoffHold hold = std::move(iter->second);
+		mHandoffsIn.erase(iter);
+
+		for (auto& held : hold.forwarded)
+			CShardManager::GetInst()->Dispatch(this, held);
+
+		for (auto& held : hold.direct)
+			CShardManager::GetInst()->Dispatch(this, held);
+	}
+
+	// 넘긴 샤드가 잡아둔 참조.
+	conn->Release();
+	return true;
+}
+
+bool CShard::IsHandoffPending(Connection* conn) const
+{
+	return conn->isHandingOff;
+}
+
+void CShard::HandOff(Connection* conn, CShard* target)
+{
+	// 담당을 바꾸기 전에 켜야 새 샤드가 바로 받은 명령을 처리하지 않음.
+	conn->isHandingOff = true;
+	conn->shardIndex = target->GetIndex();
+
+	// HandoffDone 에 실려서 받는 샤드가 놓음.
+	conn->AddRef();
+	mHandoffsOut.push_back(FHandoffOut{ conn, target, false });
+}
+
+// DrainCommands 바로 뒤에 부름.
+void CShard::FlushHandoffs()
+{
+	for (size_t i = 0; i < mHandoffsOut.size();)
+	{
+		FHandoffOut& handoff = mHandoffsOut[i];
+
+		// 넣는 중인 스레드가 없는걸 본 다음 한번 더 비워야 그 사이에 들어온 명령까지 넘어감.
+		if (!handoff.isDrained)
+		{
+			handoff.isDrained = handoff.conn->postingCount == 0;
+			i++;
+			continue;
+		}
+
+		FShardCommand command;
+		command.type = EShardCommand::HandoffDone;
+		command.conn = handoff.conn;
+		handoff.target->Post(command);
+
+		mHandoffsOut[i] = mHandoffsOut.back();
+		mHandoffsOut.pop_back();
+	}
+
+	// 받는 샤드가 기다리고 있어서 다음 틱까지 자지 않음.
+	if (!mHandoffsOut.empty() && !mIsWakePending.exchange(true))
+		SetEvent(mWakeEvent);
+}
+
+std::shared_ptr<const std::vector<RoomSummary>> CShard::GetPublishedRooms() const
+{
+	return std::atomic_load(&mPublishedRooms);
+}
+
+void CShard::PublishRooms()
+{
+	std::vector<RoomSummary> rooms;
+	mRooms.CollectRoomList(rooms);
+
+	// 쓰는건 이 스레드뿐이라 그냥 읽어도 됨.
+	const std::vector<RoomSummary>& published = *mPublishedRooms;
+
+	if (rooms.size() == published.size()
+		&& (rooms.empty() || memcmp(rooms.data(), published.data(), sizeof(RoomSummary) * rooms.size()) == 0))
+		return;
+
+	std::atomic_store(&mPublishedRooms, std::make_shared<const std::vector<RoomSummary>>(std::move(rooms)));
+}
+
+void CShard::PublishStats()
+{
+	mLoadPermille = (int)(mScheduler.GetLoad() * 1000);
+	mRoomCount = mRooms.GetRoomCount();
+	mRunningRoomCount = mRooms.GetRunningRoomCount();
+	mScheduledTimers = mRooms.GetScheduledTimerCount();
+}
+
+void CShard::MigrateRoomTo(CShard* target, int targetLoadPermille)
+{
+	CRoom* room = mRooms.PickRoomToMigrate(mLoadPermille, targetLoadPermille);
+	if (!room)
+		return;
+
+	// 아직 넘겨받는 중인 클라가 있으면 또 넘기지 않음. 다음 검사때 다시 고름.
+	for (auto& client : room->GetClients())
+	{
+		if (IsHandoffPending(client->conn))
+			return;
+	}
+
+	int roomId = room->GetId();
+
+	mRooms.DetachRoom(room);
+	CShardManager::GetInst()->MoveRoom(roomId, target->GetIndex());
+
+	// 방 상태와 클라들은 그대로 넘기고 이후로 이 샤드는 건드리지 않음.
+	// 클라 연결 담당은 AdoptRoom 이 먼저 들어간 뒤에 바꿔야 뒤따르는 메시지가 방이 붙은 다음에 처리됨.
+	// 넘긴 뒤로는 방을 읽으면 안 돼서 번호와 연결을 먼저 챙겨둠.
+	std::vector<Connection*> conns;
+	for (auto& client : room->GetClients())
+		conns.push_back(client->conn);
+
+	FShardCommand command;
+	command.type = EShardCommand::AdoptRoom;
+	command.target = room;
+	target->Post(command);
+
+	for (auto& conn : conns)
+		HandOff(conn, target);
+
+	mMigratedOut++;
+
+	std::cout << "[Room " << roomId << "] migrated shard " << mIndex << " -> " << target->GetIndex()
+		<< " (load " << mLoadPermille / 10 << "% -> " << targetLoadPermille / 10 << "%)\n";
+}
+
+void CShard::AdoptRoom(CRoom* room)
+{
+	mRooms.AttachRoom(room);
+	mMigratedIn++;
+}
+
+// 틱 경계나 들어온 명령에 깨어나서, 명령부터 처리하고 밀린 틱을 돌림.
+// 진행중인 게임이 없으면 명령이 올때까지 스케줄러 안에서 잠.
+void CShard::ThreadLoop()
+{
+	tCurrentShard = this;
+	const float dt = mScheduler.GetTickDelta();
+
+	while (true)
+	{
+		int tickCount = mScheduler.WaitForNextTicks(mWakeEvent);
+
+		DrainCommands();
+		FlushHandoffs();
+		FlushOutbox();
+
+		for (int i = 0; i < tickCount; i++)
+			mRooms.Update(dt);
+
+		if (tickCount > 0)
+			mScheduler.EndTicks();
+
+		// 게임중인 방이 하나도 없으면 다음 시작까지 재움.
+		mScheduler.SetActive(mRooms.HasRunningRoom());
+
+		PublishRooms();
+		PublishStats();
+
+		// 이번에 쌓인 송신을 한번에 내보냄.
+		CMessageSender::GetInst()->GetNetwork()->Flush();
+
+		mScheduler.ReportStats();
+	}
+}
@@ -0,0 +1,119 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Etc/MpscQueue.h"
+#include "Etc/TickScheduler.h"
+#include "Game/RoomManager.h"
+#include "Game/ShardCommand.h"
+
+// 코어 하나를 맡는 게임 스레드.
+// 자기 방들과 그 방에 있는 클라 메시지를 이 스레드 혼자 처리해서 락이 없음.
+// 다른 스레드는 Post 로 명령을 넣기만 하고, 샤드가 틱 시작 전에 한번에 꺼내서 처리함.
+class CShard
+{
+private:
+	int mIndex = 0;
+	std::thread mThread;
+
+	// 명령이 들어오면 틱 대기중이어도 깨움. 자동 리셋.
+	HANDLE mWakeEvent = nullptr;
+
+	// 이미 깨워놨으면 SetEvent 를 또 부르지 않음.
+	std::atomic<bool> mIsWakePending{ false };
+
+	CMpscQueue<FShardCommand, SHARD_QUEUE_CAPACITY> mCommands;
+	CTickScheduler mScheduler;
+	CRoomManager mRooms;
+
+	// 다른 샤드가 로비 목록을 만들때 읽는 이 샤드 방 요약. 바뀔때마다 통째로 바꿔 끼움.
+	std::shared_ptr<const std::vector<RoomSummary>> mPublishedRooms;
+
+	// 다른 샤드로 넘긴 연결. 옛 담당을 보고 이 큐에 넣던 명령까지 다 넘긴 뒤에 HandoffDone 을 보냄.
+	struct FHandoffOut
+	{
+		Connection* conn;
+		CShard* target;
+
+		// 넣는 중인 스레드가 없는걸 봤음. 한번 더 비우고 나면 보냄.
+		bool isDrained;
+	};
+
+	std::vector<FHandoffOut> mHandoffsOut;
+
+	// 넘겨받는 중인 연결의 쌓아둔 명령. HandoffDone 이 오면 옛 샤드가 넘긴 것, 바로 온 것 순서로 처리함.
+	struct FHandoffHold
+	{
+		std::vector<FShardCommand> forwarded;
+		std::vector<FShardCommand> direct;
+	};
+
+	std::unordered_map<Connection*, FHandoffHold> mHandoffsIn;
+
+	// 다른 샤드 큐가 꽉 차서 못 넣은 명령. 받는 샤드 번호별로 넣으려던 순서대로 쌓음.
+	// 샤드끼리 서로 자리를 기다리면 둘 다 안 비워서 멈추니까 기다리지 않고 여기 뒀다가 루프마다 다시 넣음.
+	std::vector<std::deque<FShardCommand>> mOutbox;
+
+	// 밸런서와 통계용. 루프 한바퀴마다 갱신. 사용률은 천분율.
+	std::atomic<int> mLoadPermille{ 0 };
+	std::atomic<int> mRoomCount{ 0 };
+	std::atomic<int> mRunningRoomCount{ 0 };
+	std::atomic<int> mScheduledTimers{ 0 };
+	std::atomic<long long> mMigratedIn{ 0 };
+	std::atomic<long long> mMigratedOut{ 0 };
+	std::atomic<long long> mDroppedCommands{ 0 };
+	std::atomic<long long> mDeferredCommands{ 0 };
+
+public:
+	CShard();
+	~CShard();
+
+	bool Init(int index);
+	void Start();
+
+	inline int GetIndex() const { return mIndex; }
+
+	// 이 샤드 스레드에서만.
+	inline CRoomManager* GetRoomManager() { return &mRooms; }
+
+	// 아무 스레드에서나. 명령은 한 스레드에서 넣은 순서대로 처리됨.
+	// 다른 샤드 스레드에서 부르면 큐가 꽉 차도 기다리거나 버리지 않고 보내는 샤드에 쌓아둠.
+	// 그 밖의 스레드는 큐가 꽉 차면 클라 메시지는 버리고 false, 나머지 명령은 자리가 날때까지 기다림.
+	bool Post(const FShardCommand& command);
+
+	// 아무 스레드에서나. 한 루프 정도 늦은 값일 수 있음.
+	std::shared_ptr<const std::vector<RoomSummary>> GetPublishedRooms() const;
+
+	inline int GetLoadPermille() const { return mLoadPermille; }
+	inline int GetRoomCount() const { return mRoomCount; }
+	inline int GetRunningRoomCount() const { return mRunningRoomCount; }
+	inline int GetScheduledTimers() const { return mScheduledTimers; }
+	inline long long GetMigratedIn() const { return mMigratedIn; }
+	inline long long GetMigratedOut() const { return mMigratedOut; }
+	inline long long GetDroppedCommands() const { return mDroppedCommands; }
+	inline long long GetDeferredCommands() const { return mDeferredCommands; }
+
+	// 이 샤드 스레드에서만. 명령 처리중 (틱 사이) 에 불려서 방이 틱 중간에 걸려있지 않음.
+	// 옮길만한 방이 있으면 클라들과 함께 target 샤드로 넘김.
+	void MigrateRoomTo(CShard* target, int targetLoadPermille);
+
+	// 이 샤드 스레드에서만. target 큐에 Adopt 명령을 넣은 다음에 불러서 연결 담당을 넘김.
+	void HandOff(Connection* conn, CShard* target);
+
+	// 이 샤드 스레드에서만. 넘겨받고 HandoffDone 을 기다리는 중인지.
+	bool IsHandoffPending(Connection* conn) const;
+
+	// 지금 스레드가 맡은 샤드. 샤드 스레드가 아니면 nullptr.
+	static CShard* GetCurrent();
+
+private:
+	void ThreadLoop();
+	void DrainCommands();
+	bool HoldCommand(const FShardCommand& command);
+	void FlushHandoffs();
+	bool TryPush(const FShardCommand& command);
+	void PostDeferred(CShard* target, const FShardCommand& command);
+	void FlushOutbox();
+	void PublishRooms();
+	void PublishStats();
+	void AdoptRoom(CRoom* room);
+};
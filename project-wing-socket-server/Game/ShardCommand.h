@@ -0,0 +1,53 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Network/Protocol.h"
+
+struct Connection;
+
+// 샤드 큐 하나에 쌓을 수 있는 명령 수. 넘치면 입력 메시지부터 버림.
+#define SHARD_QUEUE_CAPACITY 16384
+
+// 명령 하나에 담는 클라 메시지 바디 최대 크기.
+// 지금 클라가 보내는 메시지는 전부 int 두개 이하라서 넘는건 I/O 스레드에서 버림.
+#define SHARD_COMMAND_BODY_MAX 8
+
+namespace EShardCommand
+{
+	enum Type
+	{
+		// conn 이 있는 명령. 담당 샤드가 바뀌었으면 따라감.
+		ClientConnected,
+		ClientMessage,
+		ClientDisconnected,
+
+		// 연결을 넘긴 샤드가 자기 큐에 남은 그 연결 명령을 다 넘긴 뒤에 보냄.
+		// 받는 샤드는 이게 올때까지 그 연결 명령을 쌓아둠. conn 이 있음.
+		HandoffDone,
+
+		// 다른 샤드로 넘어가는 클라. target 은 Client*, arg0 방 번호, arg1 빠른 입장 여부.
+		AdoptClient,
+
+		// 샤드 사이 방 이동. AdoptRoom 의 target 은 CRoom*.
+		// MigrateRoom 은 arg0 받을 샤드, arg1 받을 샤드 사용률 (천분율).
+		AdoptRoom,
+		MigrateRoom
+	};
+}
+
+// I/O 스레드나 다른 샤드가 샤드 큐에 넣는 명령. 힙 할당 없이 값으로 복사됨.
+struct FShardCommand
+{
+	EShardCommand::Type type = EShardCommand::ClientMessage;
+	Connection* conn = nullptr;
+	void* target = nullptr;
+	int arg0 = 0;
+	int arg1 = 0;
+
+	// 옛 담당 샤드가 다시 넘긴 명령. 넘겨받는 중이면 바로 온 명령보다 먼저 처리함.
+	bool isForwarded = false;
+
+	// ClientMessage 전용.
+	MessageHeader header{};
+	char body[SHARD_COMMAND_BODY_MAX];
+};
@@ -0,0 +1,202 @@
+﻿#include "Game/ShardManager.h"
+
+DEFINITION_SINGLE(CShardManager);
+
+CShardManager::CShardManager()
+{
+
+}
+
+CShardManager::~CShardManager()
+{
+	for (auto& shard : mShards)
+		delete shard;
+}
+
+bool CShardManager::Init(int shardCount, CommandHandler handler)
+{
+	mHandler = std::move(handler);
+
+	for (int i = 0; i < shardCount; i++)
+	{
+		CShard* shard = new CShard;
+
+		if (!shard->Init(i))
+		{
+			std::cout << "[Shard " << i << "] init failed.\n";
+			delete shard;
+			return false;
+		}
+
+		mShards.push_back(shard);
+	}
+
+	std::cout << "[Server] game shards: " << shardCount << "\n";
+	return true;
+}
+
+void CShardManager::Start()
+{
+	for (auto& shard : mShards)
+		shard->Start();
+}
+
+int CShardManager::PickHomeShard()
+{
+	return (int)(mNextHomeShard++ % mShards.size());
+}
+
+void CShardManager::Post(Connection* conn, FShardCommand command)
+{
+	command.conn = conn;
+	conn->AddRef();
+
+	// 담당을 읽고 큐에 넣을때까지. 넘기는 샤드가 이게 끝나길 기다림.
+	conn->postingCount++;
+	bool isPosted = mShards[conn->shardIndex]->Post(command);
+	conn->postingCount--;
+
+	if (!isPosted)
+		conn->Release();
+}
+
+// 샤드 스레드에서 호출.
+void CShardManager::Dispatch(CShard* shard, const FShardCommand& command)
+{
+	Connection* conn = command.conn;
+
+	if (conn)
+	{
+		int shardIndex = conn->shardIndex;
+
+		// 다른 샤드 방으로 옮겨간 연결이면 거기로 다시 넘김. 잡아둔 참조도 같이 넘어감.
+		if (shardIndex != shard->GetIndex())
+		{
+			FShardCommand forwarded = command;
+			forwarded.isForwarded = true;
+
+			if (!mShards[shardIndex]->Post(forwarded))
+				conn->Release();
+			return;
+		}
+	}
+
+	mHandler(command);
+
+	if (conn)
+		conn->Release();
+}
+
+int CShardManager::RegisterRoom(int shardIndex)
+{
+	for (auto& slot : mRoomSlots)
+	{
+		int expected = 0;
+		if (!slot.roomId.compare_exchange_strong(expected, -1))
+			continue;
+
+		int roomId = mNextRoomId++;
+		slot.shardIndex = shardIndex;
+		slot.roomId = roomId;
+		return roomId;
+	}
+
+	return 0;
+}
+
+void CShardManager::UnregisterRoom(int roomId)
+{
+	for (auto& slot : mRoomSlots)
+	{
+		if (slot.roomId != roomId)
+			continue;
+
+		slot.shardIndex = -1;
+		slot.roomId = 0;
+		return;
+	}
+}
+
+int CShardManager::FindRoomShard(int roomId) const
+{
+	if (roomId <= 0)
+		return -1;
+
+	for (auto& slot : mRoomSlots)
+	{
+		if (slot.roomId == roomId)
+			return slot.shardIndex;
+	}
+
+	return -1;
+}
+
+void CShardManager::MoveRoom(int roomId, int shardIndex)
+{
+	for (auto& slot : mRoomSlots)
+	{
+		if (slot.roomId == roomId)
+		{
+			slot.shardIndex = shardIndex;
+			return;
+		}
+	}
+}
+
+void CShardManager::Balance()
+{
+	if (mShards.size() < 2)
+		return;
+
+	CShard* hot = mShards[0];
+	CShard* cold = mShards[0];
+
+	for (auto& shard : mShards)
+	{
+		if (shard->GetLoadPermille() > hot->GetLoadPermille())
+			hot = shard;
+
+		if (shard->GetLoadPermille() < cold->GetLoadPermille())
+			cold = shard;
+	}
+
+	int hotLoad = hot->GetLoadPermille();
+	int coldLoad = cold->GetLoadPermille();
+
+	if (hotLoad < SHARD_BALANCE_MIN_LOAD || hotLoad - coldLoad < SHARD_BALANCE_MIN_GAP)
+		return;
+
+	// 방은 틱 사이에 가진 샤드가 직접 떼어내야 해서 명령으로 넘김.
+	FShardCommand command;
+	command.type = EShardCommand::MigrateRoom;
+	command.arg0 = cold->GetIndex();
+	command.arg1 = coldLoad;
+	hot->Post(command);
+}
+
+void CShardManager::ReportStats()
+{
+	for (auto& shard : mShards)
+	{
+		std::cout << "[Shard " << shard->GetIndex() << "] load " << shard->GetLoadPermille() / 10 << "%"
+			<< ", rooms " << shard->GetRoomCount()
+			<< " (running " << shard->GetRunningRoomCount() << ")"
+			<< ", timers " << shard->GetScheduledTimers()
+			<< ", migrated in " << shard->GetMigratedIn()
+			<< " / out " << shard->GetMigratedOut()
+			<< ", dropped commands " << shard->GetDroppedCommands()
+			<< ", deferred " << shard->GetDeferredCommands() << "\n";
+	}
+}
+
+void CShardManager::CollectRoomList(std::vector<RoomSummary>& outRooms, int skipShardIndex) const
+{
+	for (auto& shard : mShards)
+	{
+		if (shard->GetIndex() == skipShardIndex)
+			continue;
+
+		std::shared_ptr<const std::vector<RoomSummary>> rooms = shard->GetPublishedRooms();
+		outRooms.insert(outRooms.end(), rooms->begin(), rooms->end());
+	}
+}
@@ -0,0 +1,77 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Game/Shard.h"
+
+// 밸런서 검사 주기. 사용률 창보다 길어야 직전 이동이 반영된 값으로 판단함.
+#define SHARD_BALANCE_INTERVAL_MS 2000
+
+// 제일 바쁜 샤드가 이보다 한가하면 옮기지 않음 (천분율).
+#define SHARD_BALANCE_MIN_LOAD 250
+
+// 바쁜 샤드와 한가한 샤드 사용률 차이가 이만큼은 나야 옮김 (천분율).
+#define SHARD_BALANCE_MIN_GAP 150
+
+// 게임 샤드들과 프로세스 전체 방 목록.
+// 연결마다 담당 샤드가 있고, I/O 스레드는 받은 메시지를 명령으로 만들어 그 샤드 큐로 넘기기만 함.
+// 샤드끼리도 서로의 방을 직접 건드리지 않고 큐로만 주고받음.
+class CShardManager
+{
+public:
+	// 샤드가 방 이동 외의 명령을 넘기는 곳. 샤드 스레드에서 불림.
+	using CommandHandler = std::function<void(const FShardCommand&)>;
+
+private:
+	// 방 번호 -> 샤드. roomId 0 은 빈 칸, -1 은 등록중.
+	struct FRoomSlot
+	{
+		std::atomic<int> roomId{ 0 };
+		std::atomic<int> shardIndex{ -1 };
+	};
+
+	std::vector<CShard*> mShards;
+	std::atomic<unsigned int> mNextHomeShard{ 0 };
+
+	FRoomSlot mRoomSlots[MAX_ROOMS];
+	std::atomic<int> mNextRoomId{ 1 };
+
+	CommandHandler mHandler;
+
+public:
+	bool Init(int shardCount, CommandHandler handler);
+	void Start();
+
+	inline int GetShardCount() const { return (int)mShards.size(); }
+	inline CShard* GetShard(int index) const { return mShards[index]; }
+
+	// 새 연결을 처음 맡길 샤드. 돌아가면서 고름.
+	int PickHomeShard();
+
+	// 연결의 담당 샤드에 명령을 넣음. 큐에 있는 사이에 담당이 바뀌면 따라감.
+	// 처리될때까지 conn 은 지워지지 않음.
+	void Post(Connection* conn, FShardCommand command);
+
+	// 샤드가 꺼낸 명령을 처리함. 담당이 아니면 담당 샤드로 다시 넘김.
+	void Dispatch(CShard* shard, const FShardCommand& command);
+
+	// 자리가 있으면 새 방 번호, 없으면 0.
+	int RegisterRoom(int shardIndex);
+	void UnregisterRoom(int roomId);
+
+	// 없으면 -1.
+	int FindRoomShard(int roomId) const;
+
+	// 방을 다른 샤드로 넘길때 넘기는 샤드가 부름.
+	void MoveRoom(int roomId, int shardIndex);
+
+	// 메인 스레드에서 주기적으로 부름.
+	// 제일 바쁜 샤드와 제일 한가한 샤드의 사용률 차이가 크면 바쁜 쪽에 방 하나를 넘기라고 시킴.
+	void Balance();
+	void ReportStats();
+
+	// skipShardIndex 를 뺀 샤드들이 마지막으로 공개한 방 목록을 붙임.
+	void CollectRoomList(std::vector<RoomSummary>& outRooms, int skipShardIndex) const;
+
+private:
+	DECLARE_SINGLE(CShardManager);
+};
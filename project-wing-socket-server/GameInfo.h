@@ -1,12 +1,18 @@
-#pragma once
+﻿#pragma once
 
 #include <iostream>
 #include <thread>
 #include <vector>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <atomic>
+#include <functional>
 #include <string>
 #include <algorithm>
 #include <unordered_set>
+#include <unordered_map>
+#include <random>
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #pragma comment(lib, "ws2_32.lib")
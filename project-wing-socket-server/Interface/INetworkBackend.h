@@ -0,0 +1,266 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Network/Protocol.h"
+#include "Network/Connection.h"
+#include "Network/Backpressure.h"
+
+// 송신 한번(WSASend)에 묶어 보내는 최대 프레임 수.
+#define SEND_GATHER_MAX 64
+
+// 소켓 계층 구현체 (WSAPoll 리액터 / IOCP) 공통 인터페이스.
+// 시작할때 하나 골라서 씀.
+class INetworkBackend abstract
+{
+public:
+	using AcceptCallback = std::function<void(SOCKET)>;
+	using MessageCallback = std::function<void(Connection*, const MessageHeader&, const char*)>;
+	using DisconnectCallback = std::function<void(Connection*)>;
+
+protected:
+	AcceptCallback mOnAccept;
+	MessageCallback mOnMessage;
+	DisconnectCallback mOnDisconnect;
+
+	FBackpressurePolicy mPolicy;
+	FBackpressureStats mStats;
+
+public:
+	virtual ~INetworkBackend() {}
+
+	virtual bool Init(int ioThreadCount, MessageCallback onMessage, DisconnectCallback onDisconnect) = 0;
+
+	// 리슨 소켓을 넘기면 이후 accept 는 백엔드가 알아서 처리함.
+	virtual bool StartAccept(SOCKET listenSock, AcceptCallback onAccept) = 0;
+
+	// 호출 이후 conn 의 참조 하나는 백엔드 몫. 끊기면 백엔드가 닫고 그 참조를 놓음.
+	virtual void AddConnection(Connection* conn) = 0;
+
+	// 프레임을 연결의 송신 큐에 쌓기만 함. 같은 프레임을 여러 연결에 넣어도 됨.
+	// 아무 샤드 스레드에서나 불러도 됨. 소켓은 건드리지 않음.
+	virtual void Enqueue(Connection* conn, const FramePtr& frame) = 0;
+
+	// 이 스레드가 쌓은 송신을 내보냄. 틱이나 메시지 처리를 한차례 끝낸 뒤에 부름.
+	// 연결마다 쌓인 프레임은 WSASend 한번으로 묶여서 나감.
+	virtual void Flush() = 0;
+
+	virtual const char* GetName() = 0;
+
+	// Init 전에 설정함.
+	void SetBackpressurePolicy(const FBackpressurePolicy& policy) { mPolicy = policy; }
+	const FBackpressureStats& GetBackpressureStats() const { return mStats; }
+
+protected:
+	// 수신 링에서 완성된 메시지를 잘라서 콜백으로 넘김. 바디는 복사 없이 링을 가리킴.
+	// 남은 조각은 다음 수신때까지 링에 둠. 헤더나 바디 길이가 말이 안되면 false.
+	bool DispatchMessages(Connection* conn)
+	{
+		CRecvRing& ring = conn->recvRing;
+
+		while (ring.GetSize() > 0)
+		{
+			MessageHeader header;
+			size_t headerLen = sizeof(header);
+
+			if (!conn->isRecvV2)
+			{
+				if (ring.GetSize() < sizeof(header))
+					break;
+
+				ring.Peek(0, &header, sizeof(header));
+			}
+			else
+			{
+				char raw[PROTOCOL_V2_MAX_HEADER];
+				size_t rawLen = std::min(ring.GetSize(), (size_t)PROTOCOL_V2_MAX_HEADER);
+				ring.Peek(0, raw, rawLen);
+
+				int decoded = DecodeHeaderV2(raw, (int)rawLen, header);
+				if (decoded < 0)
+					return false;
+				if (decoded == 0)
+					break;
+
+				headerLen = decoded;
+			}
+
+			if (header.bodyLen < 0 || header.bodyLen > MAX_CLIENT_BODY_LEN)
+				return false;
+
+			size_t frameLen = headerLen + header.bodyLen;
+			if (ring.GetSize() < frameLen)
+				break;
+
+			const char* body = ring.View(headerLen, header.bodyLen);
+			mOnMessage(conn, header, body);
+
+			// 클라는 HELLO 바로 다음부터 고른 버전으로 보냄. 응답은 게임 쪽이 보냄.
+			if (!conn->isRecvV2 && header.msgType == ClientMessage::MSG_PROTOCOL_HELLO && header.bodyLen == sizeof(int))
+			{
+				int version;
+				memcpy(&version, body, sizeof(int));
+				conn->isRecvV2 = version >= PROTOCOL_VERSION_V2;
+			}
+
+			ring.Consume(frameLen);
+		}
+
+		return true;
+	}
+
+	// 정책을 확인하고 송신 큐에 넣음. ioMutex 잡은 상태로 호출.
+	// false 면 큐가 안 바뀐 것. 끊어야 하면 isEvicted 를 세우고 실제 정리는 백엔드가 함.
+	bool QueueFrame(Connection* conn, const FramePtr& frame)
+	{
+		if (conn->isEvicted)
+			return false;
+
+		if (frame->isConflatable && ReplaceConflated(conn, frame))
+			return true;
+
+		if (!AdmitFrame(conn, frame))
+			return false;
+
+		unsigned long long seq = conn->sendQueueBaseSeq + conn->sendQueue.size();
+
+		if (frame->isConflatable)
+			conn->conflationSlots[frame->conflationKey] = seq;
+
+		conn->sendQueue.push_back(frame);
+
+		// 이 응답까지는 v1, 그 뒤로는 v2.
+		if (frame->isProtocolSwitch)
+			conn->v2SendFromSeq = seq + 1;
+
+		return true;
+	}
+
+	// 아직 안 나간 같은 키의 이전 값이 있으면 그 자리에 새 값을 덮어씀.
+	// 큐 길이가 안 늘어서 밀린 클라도 최신 값만 받고 바로 따라잡음.
+	bool ReplaceConflated(Connection* conn, const FramePtr& frame)
+	{
+		auto iter = conn->conflationSlots.find(frame->conflationKey);
+		if (iter == conn->conflationSlots.end())
+			return false;
+
+		// 이미 나가기 시작한 앞쪽 프레임은 건드리면 안됨.
+		size_t pinnedCount = std::max<size_t>(conn->inFlightFrames, conn->sendOffset > 0 ? 1 : 0);
+		if (iter->second < conn->sendQueueBaseSeq + pinnedCount)
+			return false;
+
+		bool isV2 = conn->IsV2At(iter->second);
+		FramePtr& slot = conn->sendQueue[(size_t)(iter->second - conn->sendQueueBaseSeq)];
+		conn->queuedBytes = conn->queuedBytes - slot->GetSize(isV2) + frame->GetSize(isV2);
+		slot = frame;
+
+		mStats.conflatedFrames++;
+		return true;
+	}
+
+	bool AdmitFrame(Connection* conn, const FramePtr& frame)
+	{
+		size_t frameSize = frame->GetSize(conn->IsV2At(conn->sendQueueBaseSeq + conn->sendQueue.size()));
+		size_t afterBytes = conn->queuedBytes + frameSize;
+
+		if (afterBytes > mPolicy.highWaterBytes)
+		{
+			ULONGLONG now = GetTickCount64();
+
+			if (conn->overHighWaterSince == 0)
+				conn->overHighWaterSince = now;
+
+			if (now - conn->overHighWaterSince > mPolicy.slowConsumerTimeoutMs)
+			{
+				mStats.slowConsumerEvictions++;
+				Evict(conn, "slow consumer");
+				return false;
+			}
+
+			if (mPolicy.dropStateUpdates && frame->isStateUpdate)
+			{
+				mStats.droppedStateFrames++;
+				mStats.droppedStateBytes += frameSize;
+				return false;
+			}
+
+			if (afterBytes > mPolicy.hardLimitBytes)
+			{
+				mStats.hardLimitEvictions++;
+				Evict(conn, "hard limit");
+				return false;
+			}
+		}
+
+		conn->queuedBytes = afterBytes;
+		return true;
+	}
+
+	void Evict(Connection* conn, const char* reason)
+	{
+		conn->isEvicted = true;
+
+		std::cout << "[" << GetName() << "] evict connection (" << reason << ")"
+			<< " queued=" << conn->queuedBytes
+			<< " dropped=" << mStats.droppedStateFrames
+			<< " slow=" << mStats.slowConsumerEvictions
+			<< " hard=" << mStats.hardLimitEvictions << "\n";
+	}
+
+	// 송신 큐 앞쪽 프레임들을 복사 없이 WSABUF 로 엮음. ioMutex 잡은 상태로 호출.
+	DWORD BuildSendBuffers(Connection* conn, WSABUF* bufs, DWORD maxCount, size_t& totalBytes)
+	{
+		DWORD bufCount = 0;
+		size_t offset = conn->sendOffset;
+		unsigned long long seq = conn->sendQueueBaseSeq;
+		totalBytes = 0;
+
+		for (auto& frame : conn->sendQueue)
+		{
+			if (bufCount == maxCount)
+				break;
+
+			bool isV2 = conn->IsV2At(seq++);
+			bufs[bufCount].buf = const_cast<char*>(frame->GetData(isV2)) + offset;
+			bufs[bufCount].len = (ULONG)(frame->GetSize(isV2) - offset);
+			totalBytes += bufs[bufCount].len;
+			bufCount++;
+			offset = 0;
+		}
+
+		return bufCount;
+	}
+
+	// 보낸 바이트 만큼 앞에서부터 프레임을 빼냄. ioMutex 잡은 상태로 호출.
+	void ConsumeSendQueue(Connection* conn, size_t bytes)
+	{
+		conn->queuedBytes -= (bytes < conn->queuedBytes) ? bytes : conn->queuedBytes;
+
+		if (conn->queuedBytes <= mPolicy.highWaterBytes)
+			conn->overHighWaterSince = 0;
+
+		while (bytes > 0 && !conn->sendQueue.empty())
+		{
+			size_t frameRemain = conn->sendQueue.front()->GetSize(conn->IsV2At(conn->sendQueueBaseSeq)) - conn->sendOffset;
+
+			if (bytes < frameRemain)
+			{
+				conn->sendOffset += bytes;
+				break;
+			}
+
+			bytes -= frameRemain;
+
+			const FramePtr& sentFrame = conn->sendQueue.front();
+			if (sentFrame->isConflatable)
+			{
+				auto iter = conn->conflationSlots.find(sentFrame->conflationKey);
+				if (iter != conn->conflationSlots.end() && iter->second == conn->sendQueueBaseSeq)
+					conn->conflationSlots.erase(iter);
+			}
+
+			conn->sendQueue.pop_front();
+			conn->sendQueueBaseSeq++;
+			conn->sendOffset = 0;
+		}
+	}
+};
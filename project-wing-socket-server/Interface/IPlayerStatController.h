@@ -20,16 +20,6 @@ private:
 	float addedDex;
 	float addedDef;
 
-	float addedReleaseStunValue;
-	float addedReleaseProtectionValue;
-
-	bool isStun; // 박았을때 잠시 멈춰야 해서.
-	bool isProtection;
-	bool isBoostMode;
-	float playDistance;
-
-	std::function<void()> playerFrezeCallback;
-
 private:
 	bool InitStat(float _maxHp, float _speed, float _dex, float _def, float _stun)
 	{
@@ -44,14 +34,6 @@ private:
 		addedDex = 0.0f;
 		addedDef = 0.0f;
 
-		addedReleaseStunValue = 0.0f;
-		addedReleaseProtectionValue = 0.0f;
-
-		isStun = false;
-		isProtection = false;
-		isBoostMode = false;
-		playDistance = 0.0f;
-
 		return true;
 	}
 
@@ -82,33 +64,6 @@ public:
 			break;
 		}
 	}
-	inline void Damaged(float _damageVal)
-	{
-		float result = _damageVal - GetDef();
-		result = result < 0.0f ? 0.0f : result;
-		curHp -= result;
-
-		if (curHp <= 0.0f && playerFrezeCallback != nullptr)
-		{
-			curHp = 0.0f;
-			playerFrezeCallback();
-			playerFrezeCallback = nullptr;
-		}
-	}
-
-	inline void DamagedPerDistance(float _damageVal)
-	{
-		float result = _damageVal - (_damageVal * (GetDef() * 0.01f));
-		result = result < 0.0f ? 0.0f : result;
-		curHp -= result;
-
-		if (curHp <= 0.0f && playerFrezeCallback != nullptr)
-		{
-			curHp = 0.0f;
-			playerFrezeCallback();
-			playerFrezeCallback = nullptr;
-		}
-	}
 	inline void AddHp(float _addHp)
 	{
 		curHp += _addHp;
@@ -119,34 +74,8 @@ public:
 	inline void AddSpeed(float _addSpeedVal) { addedSpeed += _addSpeedVal; }
 	inline void AddDex(float _addDexVal) { addedDex += _addDexVal; }
 	inline void AddDef(float _addDefVal) { addedDef += _addDefVal; }
-	inline void AddPlayDistance(float _addDist) { playDistance += _addDist; }
-	inline void SetStun() { isStun = true; }
-	inline void SetIsBoostMode(const bool _isBoostMode) { isBoostMode = _isBoostMode; }
-	inline void ReleaseStun(float DeltaTime)
-	{
-		addedReleaseStunValue += DeltaTime;
-		//std::cout 
-		//	<< " DeltaTime: " << DeltaTime
-		//	<< " addedReleaseStunValue: " << addedReleaseStunValue << "\n";
-
-		if (addedReleaseStunValue > stunDuration)
-		{
-			//std::cout
-			//	<< " addedReleaseStunValue: isStun = false;" << "\n";
-			addedReleaseStunValue = 0.0f;
-			isStun = false;
-			isProtection = true;
-		}
-	}
-	inline void ReleaseProtection(float DeltaTime)
-	{
-		addedReleaseProtectionValue += DeltaTime;
-		if (addedReleaseProtectionValue > 2.0f)
-		{
-			addedReleaseProtectionValue = 0.0f;
-			isProtection = false;
-		}
-	}
+	// 게임중 HP, 거리, 부스트, 스턴/무적은 CPlayerSim 이 들고 데미지 계산도 거기서 함.
+	// 여기 값은 게임 시작할때 CPlayerSim 에 옮겨 담는 시작 스탯.
 
 	//inline int GetIndex() { return index; }
 	inline float GetMaxHP() { return maxHp; }
@@ -156,24 +85,4 @@ public:
 	inline float GetDef() { return baseDef + addedDef; }
 	inline float GetStunDuration() { return stunDuration; }
 	inline bool GetIsDeath() { return GetCurHP() > 0.0f; }
-	inline bool GetIsStun() { return isStun; }
-	inline bool GetIsProtection() { return isProtection; }
-	inline float GetBoostValue() { return isBoostMode ? 2.0f : 1.0f; }
-	inline float GetPlayDistance() { return playDistance; }
-
-
-//public:
-//	// 콜백 함수들 등록
-//	template <typename T>
-//	void SetPlayerFrezeCallback(T* Obj, void(T::* Func)())
-//	{
-//		playerFrezeCallback = std::bind(Func, Obj);
-//	}
-//
-//	// 람다 넣으려고.
-//	using T = std::function<void()>;
-//	void SetPlayerFrezeCallback(T&& Func)
-//	{
-//		playerFrezeCallback = std::move(Func);
-//	}
 };
@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+
+// 송신 큐에 쌓인 바이트가 이걸 넘으면 상태 업데이트부터 버림.
+#define SEND_HIGH_WATER_BYTES (64 * 1024)
+
+// 이벤트 메시지까지 포함해서 이걸 넘으면 바로 끊음.
+#define SEND_HARD_LIMIT_BYTES (1024 * 1024)
+
+// high-water 위에 이 시간 이상 머물면 느린 클라로 보고 끊음.
+#define SLOW_CONSUMER_TIMEOUT_MS 3000
+
+// 느린 클라 대응 정책. 백엔드마다 하나씩 들고 있음.
+struct FBackpressurePolicy
+{
+	size_t highWaterBytes = SEND_HIGH_WATER_BYTES;
+	size_t hardLimitBytes = SEND_HARD_LIMIT_BYTES;
+	ULONGLONG slowConsumerTimeoutMs = SLOW_CONSUMER_TIMEOUT_MS;
+
+	// high-water 위에서 상태 업데이트(스냅샷 등)를 버릴지.
+	// 끄면 상태 업데이트도 이벤트처럼 쌓다가 hard limit 에서 끊김.
+	bool dropStateUpdates = true;
+};
+
+// 정책별로 몇번 걸렸는지. 여러 스레드에서 올리니 atomic.
+struct FBackpressureStats
+{
+	std::atomic<long long> conflatedFrames{ 0 };
+	std::atomic<long long> droppedStateFrames{ 0 };
+	std::atomic<long long> droppedStateBytes{ 0 };
+	std::atomic<long long> slowConsumerEvictions{ 0 };
+	std::atomic<long long> hardLimitEvictions{ 0 };
+};
@@ -0,0 +1,206 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+
+// 실수 하나를 정수 칸 번호로 줄이는 규칙. [minValue, maxValue] 를 step 간격으로 나눔.
+// 범위 밖 값은 양 끝으로 붙이고, 안쪽 값은 가장 가까운 칸으로 반올림해서 오차는 step / 2 이하.
+struct FQuantSpec
+{
+	float minValue;
+	float maxValue;
+	float step;
+	unsigned int maxCode;	// 마지막 칸 번호. maxValue 가 여기에 들어감.
+	int bits;
+};
+
+// 0 ~ n 을 담는데 필요한 비트 수.
+constexpr int BitsForCode(unsigned int n)
+{
+	int bits = 0;
+
+	while (n > 0)
+	{
+		bits++;
+		n >>= 1;
+	}
+
+	return bits;
+}
+
+constexpr FQuantSpec MakeQuantSpec(float minValue, float maxValue, float step)
+{
+	return FQuantSpec{ minValue, maxValue, step,
+		(unsigned int)((maxValue - minValue) / step + 0.5f),
+		BitsForCode((unsigned int)((maxValue - minValue) / step + 0.5f)) };
+}
+
+constexpr unsigned int Quantize(const FQuantSpec& spec, float value)
+{
+	// NaN 도 여기서 0 으로.
+	if (!(value > spec.minValue))
+		return 0;
+
+	if (value >= spec.maxValue)
+		return spec.maxCode;
+
+	unsigned int code = (unsigned int)((value - spec.minValue) / spec.step + 0.5f);
+	return code > spec.maxCode ? spec.maxCode : code;
+}
+
+constexpr float Dequantize(const FQuantSpec& spec, unsigned int code)
+{
+	return spec.minValue + spec.step * (float)code;
+}
+
+// 범위 안 값 하나를 줄였다 되살렸을때의 오차. 스펙마다 static_assert 로 확인함.
+constexpr float QuantRoundTripError(const FQuantSpec& spec, float value)
+{
+	float error = Dequantize(spec, Quantize(spec, value)) - value;
+	return error < 0.0f ? -error : error;
+}
+
+// 범위 양 끝과 안쪽 몇 곳에서 오차가 step / 2 (+ float 반올림 여유) 안에 드는지.
+constexpr bool IsQuantSpecTight(const FQuantSpec& spec)
+{
+	const float fractions[] = { 0.0f, 0.0001f, 0.1234f, 0.25f, 0.5f, 0.6789f, 0.9999f, 1.0f };
+	const float bound = spec.step * 0.5f * 1.01f;
+
+	for (float f : fractions)
+	{
+		float value = spec.minValue + (spec.maxValue - spec.minValue) * f;
+		if (QuantRoundTripError(spec, value) > bound)
+			return false;
+	}
+
+	return spec.bits > 0 && spec.bits <= 32;
+}
+
+// 값을 낮은 비트부터 이어 붙임. 바이트 안에서도 낮은 비트가 먼저.
+// 바이트 단위로 끝나도록 마지막에 Flush 를 불러야 함.
+class CBitWriter
+{
+private:
+	std::vector<char>& mOut;
+	unsigned long long mScratch = 0;
+	int mScratchBits = 0;
+
+public:
+	// out 뒤에 이어서 씀.
+	explicit CBitWriter(std::vector<char>& out) : mOut(out) {}
+
+	// bits 는 1 ~ 32.
+	void Write(unsigned int value, int bits)
+	{
+		unsigned long long mask = (1ULL << bits) - 1;
+		mScratch |= ((unsigned long long)value & mask) << mScratchBits;
+		mScratchBits += bits;
+
+		while (mScratchBits >= 8)
+		{
+			mOut.push_back((char)(mScratch & 0xFF));
+			mScratch >>= 8;
+			mScratchBits -= 8;
+		}
+	}
+
+	inline void WriteBool(bool value) { Write(value ? 1 : 0, 1); }
+
+	// 작은 값이 대부분인 정수 (id, 틱). 7비트씩 끊고 이어지면 1비트를 붙임.
+	void WriteVar(unsigned int value)
+	{
+		while (value >= 0x80)
+		{
+			Write((value & 0x7F) | 0x80, 8);
+			value >>= 7;
+		}
+
+		Write(value, 8);
+	}
+
+	inline void WriteQuant(const FQuantSpec& spec, float value) { Write(Quantize(spec, value), spec.bits); }
+
+	// 남은 비트를 0 으로 채워서 바이트를 맞춤.
+	void Flush()
+	{
+		if (mScratchBits > 0)
+			Write(0, 8 - mScratchBits);
+	}
+};
+
+// CBitWriter 로 쓴걸 읽음. 바디 끝을 넘어 읽으려 하면 0 을 돌려주고 이후로 계속 실패 상태.
+class CBitReader
+{
+private:
+	const unsigned char* mData;
+	int mLen;
+	int mBitPos = 0;
+	bool mIsFailed = false;
+
+public:
+	CBitReader(const char* data, int len) : mData((const unsigned char*)data), mLen(len) {}
+
+	inline bool IsFailed() const { return mIsFailed; }
+	inline int GetRemainBits() const { return mLen * 8 - mBitPos; }
+
+	unsigned int Read(int bits)
+	{
+		if (mIsFailed || bits > GetRemainBits())
+		{
+			mIsFailed = true;
+			return 0;
+		}
+
+		unsigned int value = 0;
+
+		for (int done = 0; done < bits;)
+		{
+			int byteIndex = mBitPos >> 3;
+			int bitInByte = mBitPos & 7;
+			int take = std::min(8 - bitInByte, bits - done);
+
+			unsigned int chunk = (mData[byteIndex] >> bitInByte) & ((1u << take) - 1);
+			value |= chunk << done;
+
+			done += take;
+			mBitPos += take;
+		}
+
+		return value;
+	}
+
+	inline bool ReadBool() { return Read(1) != 0; }
+
+	unsigned int ReadVar()
+	{
+		unsigned int value = 0;
+
+		for (int i = 0; i < 5; i++)
+		{
+			unsigned int b = Read(8);
+			value |= (b & 0x7F) << (7 * i);
+
+			if (!(b & 0x80))
+				return value;
+		}
+
+		// 5바이트를 넘는 값은 없음.
+		mIsFailed = true;
+		return 0;
+	}
+
+	// 줄인 칸 번호 그대로. 마지막 칸을 넘으면 실패.
+	inline unsigned int ReadCode(const FQuantSpec& spec)
+	{
+		unsigned int code = Read(spec.bits);
+
+		if (code > spec.maxCode)
+		{
+			mIsFailed = true;
+			return 0;
+		}
+
+		return code;
+	}
+
+	inline float ReadQuant(const FQuantSpec& spec) { return Dequantize(spec, ReadCode(spec)); }
+};
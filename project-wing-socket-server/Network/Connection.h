@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Network/Frame.h"
+#include "Network/RecvRing.h"
+
+struct Client;
+
+// 소켓 하나에 대한 네트워크 쪽 상태.
+// 게임 쪽 상태는 Client 가 들고 있고, 서로 포인터로 연결됨.
+// 백엔드, 게임 쪽, 샤드 큐에 걸린 작업이 각각 참조를 잡고 있고 마지막에 놓는 쪽이 지움.
+struct Connection
+{
+	SOCKET sock = INVALID_SOCKET;
+
+	// 담당 샤드 스레드에서만 건드림.
+	Client* client = nullptr;
+
+	// 이 연결의 메시지를 처리하는 샤드. 다른 샤드의 방으로 옮기면 바뀜.
+	std::atomic<int> shardIndex{ 0 };
+
+	// 담당 샤드를 읽고 그 큐에 넣는 중인 스레드 수.
+	// 연결을 넘긴 샤드는 이게 0 인걸 본 뒤에야 HandoffDone 을 보내서, 옛 담당을 보고 넣은 명령이 뒤처지지 않음.
+	std::atomic<int> postingCount{ 0 };
+
+	// 넘기는 샤드가 shardIndex 를 바꾸기 전에 켬. 켜져 있는 동안 새 담당 샤드는 이 연결 명령을 쌓아두고,
+	// HandoffDone 을 받으면 끄고 처리함. Adopt 가 아직 보내는 샤드에 쌓여 있어도 먼저 온 명령이 처리되지 않음.
+	std::atomic<bool> isHandingOff{ false };
+
+	std::atomic<int> refCount{ 1 };
+
+	// 어느 I/O 스레드가 이 연결을 담당하는지.
+	int ioThreadIndex = -1;
+
+	// 백엔드 전용 상태 (IOCP overlapped 등). 백엔드가 만들고 지움.
+	void* backendContext = nullptr;
+
+	// 아직 메시지 단위로 잘리지 않은 수신 데이터.
+	CRecvRing recvRing;
+
+	// 클라가 MSG_PROTOCOL_HELLO 로 v2 를 고른 뒤로 수신을 v2 헤더로 자름. I/O 스레드만 씀.
+	bool isRecvV2 = false;
+
+	// 송신 큐와 백엔드의 I/O 등록은 이걸로 보호함.
+	std::mutex ioMutex;
+
+	// 백엔드가 소켓을 닫은 연결. 게임 쪽이 아직 들고 있어도 이후 Enqueue 는 무시됨.
+	bool isClosed = false;
+
+	// 아직 못 보낸 프레임들. 맨 앞 프레임은 sendOffset 까지 나간 상태.
+	std::deque<FramePtr> sendQueue;
+	size_t sendOffset = 0;
+
+	// 큐 맨 앞 프레임의 일련번호. 뒤로 갈수록 1씩 늘어남.
+	unsigned long long sendQueueBaseSeq = 0;
+
+	// 이 일련번호부터의 프레임은 v2 인코딩으로 보냄. v1 이면 끝까지 안 옴.
+	unsigned long long v2SendFromSeq = ~0ULL;
+
+	// 큐에 있는 최신 값 프레임 위치. conflationKey → 일련번호.
+	std::unordered_map<unsigned long long, unsigned long long> conflationSlots;
+
+	// WSASend 에 걸려 있어서 바꾸면 안 되는 앞쪽 프레임 수. IOCP 만 씀.
+	size_t inFlightFrames = 0;
+
+	// 큐에 남은 바이트 수와 high-water 를 처음 넘은 시각(0 이면 아래).
+	size_t queuedBytes = 0;
+	ULONGLONG overHighWaterSince = 0;
+
+	// 송신이 너무 밀려서 끊기로 한 연결. 이후 Enqueue 는 무시됨.
+	std::atomic<bool> isEvicted{ false };
+
+	// 큐에 보낼게 쌓여서 I/O 스레드가 내보내야 하는지.
+	std::atomic<bool> wantWrite{ false };
+
+	// 송신 버퍼가 차서 쓰기 가능 이벤트를 기다리는 중인지. 리액터 I/O 스레드만 씀.
+	bool isWriteBlocked = false;
+
+	// ioMutex 잡은 상태로.
+	inline bool IsV2At(unsigned long long seq) const { return seq >= v2SendFromSeq; }
+
+	inline void AddRef() { refCount++; }
+
+	inline void Release()
+	{
+		if (--refCount == 0)
+			delete this;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,95 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Network/Protocol.h"
+
+// 헤더 + 바디가 이미 인코딩된 송신 단위.
+// 만든 뒤로는 수정하지 않고, 브로드캐스트면 같은 프레임을 모든 수신자 큐가 같이 들고 있음.
+// 연결마다 헤더 버전이 달라서 v2 인코딩은 처음 v2 연결로 나갈때 한번만 만들어 둠.
+// v1 만 쓰는 연결만 받는 프레임은 바디를 한번만 복사함.
+struct Frame
+{
+	// v1 인코딩.
+	std::vector<char> bytes;
+	int msgType = 0;
+
+	// v2 헤더 길이. 큐 크기 계산은 v2 인코딩 없이 이걸로 함.
+	int v2HeaderSize = 0;
+
+	// MSG_PROTOCOL_ACK. 큐에 들어가는 순간 이 뒤로 그 연결은 v2 로 나감.
+	bool isProtocolSwitch = false;
+
+	// 송신이 밀렸을때 버려도 되는 프레임인지.
+	bool isStateUpdate = false;
+
+	// 큐에 아직 안 나간 같은 키의 프레임이 있으면 그 자리를 덮어씀.
+	bool isConflatable = false;
+	unsigned long long conflationKey = 0;
+
+	// v1 인코딩. UDP 는 항상 이쪽.
+	inline const char* GetData() const { return bytes.data(); }
+	inline int GetSize() const { return (int)bytes.size(); }
+
+	inline const char* GetData(bool isV2) const { return isV2 ? GetV2Data() : bytes.data(); }
+	inline int GetSize(bool isV2) const { return isV2 ? v2HeaderSize + GetBodySize() : GetSize(); }
+
+private:
+	// 여러 I/O 스레드가 동시에 처음 v2 로 보낼 수 있어서 한번만 만들게 막음.
+	mutable std::once_flag v2Once;
+	mutable std::vector<char> v2Bytes;
+
+	inline int GetBodySize() const { return (int)bytes.size() - (int)sizeof(MessageHeader); }
+
+	const char* GetV2Data() const
+	{
+		std::call_once(v2Once, [this]()
+			{
+				MessageHeader header;
+				memcpy(&header, bytes.data(), sizeof(header));
+
+				v2Bytes.resize(v2HeaderSize + header.bodyLen);
+				EncodeHeaderV2(v2Bytes.data(), header.senderId, header.msgType, header.bodyLen);
+
+				if (header.bodyLen > 0)
+					memcpy(v2Bytes.data() + v2HeaderSize, bytes.data() + sizeof(header), header.bodyLen);
+			});
+
+		return v2Bytes.data();
+	}
+};
+
+using FramePtr = std::shared_ptr<const Frame>;
+
+inline std::shared_ptr<Frame> EncodeFrame(int senderId, int msgType, const void* body, int bodyLen)
+{
+	char headerV2[PROTOCOL_V2_MAX_HEADER];
+
+	auto frame = std::make_shared<Frame>();
+	frame->bytes.resize(sizeof(MessageHeader) + bodyLen);
+	frame->msgType = msgType;
+	frame->v2HeaderSize = EncodeHeaderV2(headerV2, senderId, msgType, bodyLen);
+	frame->isStateUpdate = IsStateUpdateMessage(msgType);
+	frame->isConflatable = IsConflatableMessage(msgType);
+	frame->conflationKey = ((unsigned long long)(unsigned int)senderId << 32) | (unsigned int)msgType;
+
+	MessageHeader header{ senderId, msgType, bodyLen };
+	memcpy(frame->bytes.data(), &header, sizeof(header));
+
+	if (body && bodyLen > 0)
+		memcpy(frame->bytes.data() + sizeof(header), body, bodyLen);
+
+	return frame;
+}
+
+inline FramePtr MakeFrame(int senderId, int msgType, const void* body, int bodyLen)
+{
+	return EncodeFrame(senderId, msgType, body, bodyLen);
+}
+
+// 정해진 버전을 알려주는 응답. v2 면 이 프레임이 큐에 들어간 바로 뒤부터 v2 로 나감.
+inline FramePtr MakeProtocolAckFrame(int version)
+{
+	auto frame = EncodeFrame(0, (int)ServerMessage::MSG_PROTOCOL_ACK, &version, sizeof(int));
+	frame->isProtocolSwitch = version >= PROTOCOL_VERSION_V2;
+	return frame;
+}
@@ -0,0 +1,372 @@
+﻿#include "Network/IocpNetworkBackend.h"
+
+DEFINITION_SINGLE(CIocpNetworkBackend);
+
+// 이 스레드가 Enqueue 만 하고 아직 Flush 안 한 연결들.
+static thread_local std::vector<void*> tDirtyContexts;
+
+CIocpNetworkBackend::CIocpNetworkBackend()
+{
+
+}
+
+CIocpNetworkBackend::~CIocpNetworkBackend()
+{
+
+}
+
+bool CIocpNetworkBackend::Init(int ioThreadCount, MessageCallback onMessage, DisconnectCallback onDisconnect)
+{
+	mOnMessage = std::move(onMessage);
+	mOnDisconnect = std::move(onDisconnect);
+
+	if (!LoadAcceptEx())
+	{
+		std::cout << "[IOCP] AcceptEx not available: " << WSAGetLastError() << "\n";
+		return false;
+	}
+
+	mIocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, ioThreadCount);
+	if (mIocp == nullptr)
+	{
+		std::cout << "[IOCP] CreateIoCompletionPort failed.\n";
+		return false;
+	}
+
+	for (int i = 0; i < ioThreadCount; i++)
+		std::thread(&CIocpNetworkBackend::WorkerLoop, this).detach();
+
+	std::cout << "[IOCP] worker threads: " << ioThreadCount << "\n";
+	return true;
+}
+
+bool CIocpNetworkBackend::LoadAcceptEx()
+{
+	SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock == INVALID_SOCKET)
+		return false;
+
+	GUID guid = WSAID_ACCEPTEX;
+	DWORD bytes = 0;
+	int r = WSAIoctl(sock, SIO_GET_EXTENSION_FUNCTION_POINTER
+		, &guid, sizeof(guid)
+		, &mAcceptEx, sizeof(mAcceptEx)
+		, &bytes, nullptr, nullptr);
+
+	closesocket(sock);
+	return r != SOCKET_ERROR && mAcceptEx != nullptr;
+}
+
+bool CIocpNetworkBackend::StartAccept(SOCKET listenSock, AcceptCallback onAccept)
+{
+	mOnAccept = std::move(onAccept);
+	mListenSock = listenSock;
+
+	if (CreateIoCompletionPort((HANDLE)mListenSock, mIocp, 0, 0) == nullptr)
+		return false;
+
+	for (auto& op : mAcceptOps)
+	{
+		op.type = EIocpOperation::Accept;
+
+		if (!PostAccept(&op))
+			return false;
+	}
+
+	return true;
+}
+
+void CIocpNetworkBackend::AddConnection(Connection* conn)
+{
+	FIocpContext* context = new FIocpContext;
+	context->conn = conn;
+	context->recvOp.type = EIocpOperation::Recv;
+	context->recvOp.context = context;
+	context->sendOp.type = EIocpOperation::Send;
+	context->sendOp.context = context;
+	conn->backendContext = context;
+
+	bool isAssociated = CreateIoCompletionPort((HANDLE)conn->sock, mIocp, (ULONG_PTR)context, 0) != nullptr;
+
+	std::lock_guard<std::mutex> lock(conn->ioMutex);
+
+	if (isAssociated && PostRecv(context))
+		return;
+
+	// 호출자가 아직 이 연결로 처리중이라 여기서 바로 정리하면 안됨.
+	// 0 바이트 수신 완료로 위장해서 워커 스레드가 정리하게 함.
+	BeginClose(context);
+	context->pendingIoCount++;
+	PostQueuedCompletionStatus(mIocp, 0, (ULONG_PTR)context, &context->recvOp.overlapped);
+}
+
+void CIocpNetworkBackend::Enqueue(Connection* conn, const FramePtr& frame)
+{
+	std::lock_guard<std::mutex> lock(conn->ioMutex);
+
+	// 이미 정리된 연결이면 context 도 없음. 락 안에서 봐야 정리와 안 겹침.
+	if (conn->isClosed)
+		return;
+
+	FIocpContext* context = (FIocpContext*)conn->backendContext;
+
+	if (context->isClosing)
+		return;
+
+	if (!QueueFrame(conn, frame))
+	{
+		if (conn->isEvicted)
+			BeginClose(context);
+		return;
+	}
+
+	// 이미 나가는 중이면 완료될때 쌓인걸 한번에 보냄.
+	if (context->isSending || context->isFlushQueued)
+		return;
+
+	// Flush 전에 연결이 정리되지 않게 하나 잡아둠.
+	context->isFlushQueued = true;
+	context->pendingIoCount++;
+	tDirtyContexts.push_back(context);
+}
+
+void CIocpNetworkBackend::Flush()
+{
+	// 정리되면서 다른 연결에 또 쌓을 수 있어서 빌때까지 돌림.
+	while (!tDirtyContexts.empty())
+	{
+		std::vector<void*> dirty;
+		dirty.swap(tDirtyContexts);
+
+		for (auto& ptr : dirty)
+		{
+			FIocpContext* context = (FIocpContext*)ptr;
+			Connection* conn = context->conn;
+
+			{
+				std::lock_guard<std::mutex> lock(conn->ioMutex);
+				context->isFlushQueued = false;
+
+				if (!context->isSending && !context->isClosing && !conn->sendQueue.empty())
+					PostSend(context);
+			}
+
+			ReleaseIo(context);
+		}
+	}
+}
+
+bool CIocpNetworkBackend::PostAccept(FIocpOperation* op)
+{
+	op->acceptSock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (op->acceptSock == INVALID_SOCKET)
+		return false;
+
+	memset(&op->overlapped, 0, sizeof(op->overlapped));
+
+	DWORD bytes = 0;
+	BOOL ok = mAcceptEx(mListenSock, op->acceptSock, op->acceptBuffer, 0
+		, sizeof(sockaddr_in) + 16, sizeof(sockaddr_in) + 16
+		, &bytes, &op->overlapped);
+
+	if (!ok && WSAGetLastError() != ERROR_IO_PENDING)
+	{
+		closesocket(op->acceptSock);
+		op->acceptSock = INVALID_SOCKET;
+		return false;
+	}
+
+	return true;
+}
+
+// ioMutex 잡은 상태로 호출.
+bool CIocpNetworkBackend::PostRecv(FIocpContext* context)
+{
+	Connection* conn = context->conn;
+
+	// 남아있던 조각 뒤의 빈 공간 전체를 걸어둠. 완료 전까지 링의 이 부분은 커널이 씀.
+	WSABUF bufs[2];
+	DWORD bufCount = conn->recvRing.GetWriteBuffers(bufs);
+
+	memset(&context->recvOp.overlapped, 0, sizeof(context->recvOp.overlapped));
+
+	DWORD flags = 0;
+	context->pendingIoCount++;
+
+	if (WSARecv(conn->sock, bufs, bufCount, nullptr, &flags, &context->recvOp.overlapped, nullptr) == SOCKET_ERROR
+		&& WSAGetLastError() != WSA_IO_PENDING)
+	{
+		context->pendingIoCount--;
+		return false;
+	}
+
+	return true;
+}
+
+// ioMutex 잡은 상태로 호출.
+bool CIocpNetworkBackend::PostSend(FIocpContext* context)
+{
+	Connection* conn = context->conn;
+
+	// 큐에 쌓인 프레임들을 복사 없이 WSABUF 로 엮어서 한번에 보냄.
+	WSABUF bufs[SEND_GATHER_MAX];
+	size_t totalBytes = 0;
+	DWORD bufCount = BuildSendBuffers(conn, bufs, SEND_GATHER_MAX, totalBytes);
+
+	memset(&context->sendOp.overlapped, 0, sizeof(context->sendOp.overlapped));
+
+	context->isSending = true;
+	context->pendingIoCount++;
+	conn->inFlightFrames = bufCount;
+
+	if (WSASend(conn->sock, bufs, bufCount, nullptr, 0, &context->sendOp.overlapped, nullptr) == SOCKET_ERROR
+		&& WSAGetLastError() != WSA_IO_PENDING)
+	{
+		context->isSending = false;
+		context->pendingIoCount--;
+		conn->inFlightFrames = 0;
+		BeginClose(context);
+		return false;
+	}
+
+	return true;
+}
+
+void CIocpNetworkBackend::WorkerLoop()
+{
+	OVERLAPPED_ENTRY entries[IOCP_COMPLETION_BATCH];
+
+	while (true)
+	{
+		ULONG count = 0;
+
+		if (!GetQueuedCompletionStatusEx(mIocp, entries, IOCP_COMPLETION_BATCH, &count, INFINITE, FALSE))
+			continue;
+
+		for (ULONG i = 0; i < count; i++)
+		{
+			// overlapped 가 첫 멤버라서 그대로 캐스팅.
+			FIocpOperation* op = reinterpret_cast<FIocpOperation*>(entries[i].lpOverlapped);
+
+			// Internal 에 NTSTATUS 가 들어있음. 0 이면 성공.
+			bool success = (entries[i].lpOverlapped->Internal == 0);
+			DWORD bytes = entries[i].dwNumberOfBytesTransferred;
+
+			switch (op->type)
+			{
+			case EIocpOperation::Accept:
+				OnAcceptCompleted(op, success);
+				break;
+
+			case EIocpOperation::Recv:
+				OnRecvCompleted(op->context, success, bytes);
+				break;
+
+			case EIocpOperation::Send:
+				OnSendCompleted(op->context, success, bytes);
+				break;
+			}
+		}
+
+		// 이번 배치에서 처리한 메시지들이 쌓은 송신을 한번에 내보냄.
+		Flush();
+	}
+}
+
+void CIocpNetworkBackend::OnAcceptCompleted(FIocpOperation* op, bool success)
+{
+	SOCKET clientSock = op->acceptSock;
+	op->acceptSock = INVALID_SOCKET;
+
+	if (success)
+	{
+		setsockopt(clientSock, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT, (char*)&mListenSock, sizeof(mListenSock));
+		mOnAccept(clientSock);
+	}
+	else
+	{
+		closesocket(clientSock);
+	}
+
+	// 바로 다시 걸어둬서 대기중인 accept 수를 유지함.
+	if (!PostAccept(op))
+		std::cout << "[IOCP] PostAccept failed: " << WSAGetLastError() << "\n";
+}
+
+void CIocpNetworkBackend::OnRecvCompleted(FIocpContext* context, bool success, DWORD bytes)
+{
+	Connection* conn = context->conn;
+
+	if (success)
+		conn->recvRing.Commit(bytes);
+
+	bool isAlive = success && bytes > 0 && DispatchMessages(conn);
+
+	{
+		std::lock_guard<std::mutex> lock(conn->ioMutex);
+
+		if (!isAlive || context->isClosing || !PostRecv(context))
+			BeginClose(context);
+	}
+
+	ReleaseIo(context);
+}
+
+void CIocpNetworkBackend::OnSendCompleted(FIocpContext* context, bool success, DWORD bytes)
+{
+	Connection* conn = context->conn;
+
+	{
+		std::lock_guard<std::mutex> lock(conn->ioMutex);
+		context->isSending = false;
+		conn->inFlightFrames = 0;
+
+		if (!success)
+		{
+			BeginClose(context);
+		}
+		else
+		{
+			ConsumeSendQueue(conn, bytes);
+
+			if (!conn->sendQueue.empty() && !context->isClosing)
+				PostSend(context);
+		}
+	}
+
+	ReleaseIo(context);
+}
+
+// ioMutex 잡은 상태로 호출.
+// 소켓은 걸린 요청이 다 끝난 뒤에 닫아야 핸들 재사용에 안 꼬임.
+void CIocpNetworkBackend::BeginClose(FIocpContext* context)
+{
+	if (context->isClosing)
+		return;
+
+	context->isClosing = true;
+	CancelIoEx((HANDLE)context->conn->sock, nullptr);
+}
+
+void CIocpNetworkBackend::ReleaseIo(FIocpContext* context)
+{
+	if (--context->pendingIoCount > 0)
+		return;
+
+	Connection* conn = context->conn;
+
+	{
+		std::lock_guard<std::mutex> lock(conn->ioMutex);
+		conn->isClosed = true;
+		conn->backendContext = nullptr;
+		conn->sendQueue.clear();
+		conn->conflationSlots.clear();
+	}
+
+	mOnDisconnect(conn);
+	closesocket(conn->sock);
+
+	// 게임 쪽 정리가 샤드에서 끝나야 실제로 지워짐.
+	conn->Release();
+	delete context;
+}
@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Interface/INetworkBackend.h"
+#include <mswsock.h>
+
+// 미리 걸어두는 AcceptEx 개수. 완료될때마다 다시 걸어서 항상 이만큼 대기함.
+#define IOCP_ACCEPT_POST_COUNT 16
+
+// GetQueuedCompletionStatusEx 한번에 꺼내오는 완료 개수.
+#define IOCP_COMPLETION_BATCH 64
+
+namespace EIocpOperation
+{
+	enum Type
+	{
+		Accept,
+		Recv,
+		Send
+	};
+}
+
+// 완료 기반 백엔드. io_uring 처럼 요청을 걸어두고 완료만 받아서 처리함.
+// - AcceptEx 를 여러개 걸어두고 완료되면 바로 재등록 (multishot accept 대용)
+// - 연결마다 수신 버퍼를 걸어두고 채워지면 파싱
+// - 송신중에 쌓인 프레임은 다음 WSASend 한번으로 몰아서 보냄 (프레임 복사 없이 WSABUF 로 묶음)
+// - 완료는 GetQueuedCompletionStatusEx 로 여러개씩 한번에 꺼냄
+class CIocpNetworkBackend : public INetworkBackend
+{
+private:
+	struct FIocpContext;
+
+	struct FIocpOperation
+	{
+		OVERLAPPED overlapped{};
+		EIocpOperation::Type type = EIocpOperation::Recv;
+		FIocpContext* context = nullptr;
+
+		// Accept 전용.
+		SOCKET acceptSock = INVALID_SOCKET;
+		char acceptBuffer[(sizeof(sockaddr_in) + 16) * 2];
+	};
+
+	struct FIocpContext
+	{
+		Connection* conn = nullptr;
+
+		FIocpOperation recvOp;
+		FIocpOperation sendOp;
+
+		// 아래 값들은 conn->ioMutex 로 보호함.
+		bool isSending = false;
+		bool isFlushQueued = false;
+		bool isClosing = false;
+
+		// 걸려있는 overlapped 요청 수. 0 이 되면 정리함.
+		std::atomic<int> pendingIoCount{ 0 };
+	};
+
+	HANDLE mIocp = nullptr;
+	SOCKET mListenSock = INVALID_SOCKET;
+	LPFN_ACCEPTEX mAcceptEx = nullptr;
+	FIocpOperation mAcceptOps[IOCP_ACCEPT_POST_COUNT];
+
+public:
+	virtual bool Init(int ioThreadCount, MessageCallback onMessage, DisconnectCallback onDisconnect) override;
+	virtual bool StartAccept(SOCKET listenSock, AcceptCallback onAccept) override;
+	virtual void AddConnection(Connection* conn) override;
+	virtual void Enqueue(Connection* conn, const FramePtr& frame) override;
+	virtual void Flush() override;
+	virtual const char* GetName() override { return "IOCP"; }
+
+private:
+	bool LoadAcceptEx();
+	bool PostAccept(FIocpOperation* op);
+	bool PostRecv(FIocpContext* context);
+	bool PostSend(FIocpContext* context);
+
+	void WorkerLoop();
+	void OnAcceptCompleted(FIocpOperation* op, bool success);
+	void OnRecvCompleted(FIocpContext* context, bool success, DWORD bytes);
+	void OnSendCompleted(FIocpContext* context, bool success, DWORD bytes);
+
+	void BeginClose(FIocpContext* context);
+	void ReleaseIo(FIocpContext* context);
+
+	DECLARE_SINGLE(CIocpNetworkBackend);
+};
@@ -0,0 +1,486 @@
+﻿#pragma once
+
+// 서버와 클라가 같이 쓰는 메시지 목록, 바디 구조체, 바디 규칙.
+// 클라 프로젝트도 그대로 include 해서 GameInfo.h 없이 표준 헤더만 씀.
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ClientMessage
+{
+	enum Type
+	{
+		MSG_HEARTBEAT,	// v4 이상이면 바디 unsigned int 로 마지막에 받은 스냅샷 번호를 붙일 수 있음.
+		MSG_START,
+		MSG_PICK_CHARACTER,
+		MSG_PICK_ITEM,
+		MSG_PICK_MAP,
+		MSG_READY,
+		MSG_UNREADY,
+		MSG_MOVE_UP,	// 하트비트처럼 스냅샷 번호를 붙일 수 있음.
+		MSG_MOVE_DOWN,
+		MSG_TAKE_DAMAGE, // 맵에 박았을때의 트리거. 바디 CollisionReport.
+		MSG_BOOST_ON,
+		MSG_BOOST_OFF,
+
+		// 로비. 방 밖에서도 보낼 수 있음.
+		MSG_ROOM_LIST,
+		MSG_CREATE_ROOM,
+		MSG_JOIN_ROOM,	// 바디 int roomId. 0 이하면 아무 대기중인 방이나.
+		MSG_LEAVE_ROOM,
+
+		// 바디 int version. MSG_PROTOCOL_OFFER 를 받은 클라만 보냄.
+		// 이 메시지는 v1 으로 보내고, 바로 다음 메시지부터 클라는 그 버전으로 보냄.
+		MSG_PROTOCOL_HELLO,
+		MSG_END
+	};
+}
+
+namespace ServerMessage
+{
+	enum Type
+	{
+		MSG_CONNECTED,
+		MSG_ROOM_FULL_INFO,
+		MSG_DISCONNECT, // 이건 누가 나간거.
+		MSG_CONNECTED_REJECT,
+		MSG_NEW_OWNER,
+		MSG_JOIN,
+
+		MSG_PICK_MAP,
+		MSG_PICK_ITEM,
+		MSG_PICK_CHARACTER,
+		MSG_READY,
+		MSG_UNREADY,
+		MSG_START_ACK,
+
+		MSG_COUNTDOWN_FINISHED,
+		MSG_PLAYER_DEAD,
+		MSG_GAME_OVER,
+		MSG_MOVE_UP,
+		MSG_MOVE_DOWN,
+		MSG_PLAYER_DISTANCE, // 거리 전송 메시지.
+		MSG_PLAYER_HEIGHT,
+		MSG_TAKEN_DAMAGE,	// 현재 HP 알려줌.
+		MSG_TAKEN_STUN,
+		MSG_BOOST_ON,
+		MSG_BOOST_OFF,
+		MSG_OBSTACLE,
+
+		MSG_HEARTBEAT_ACK,
+		MSG_WORLD_SNAPSHOT, // 틱마다 모든 플레이어 상태를 한번에.
+		MSG_UDP_OFFER,		// 접속 직후 UDP 포트와 토큰을 알려줌. 클라가 원하면 UDP Hello 로 응답.
+		MSG_UDP_READY,		// Hello 를 받았음. 이후 게임중 메시지 일부는 UDP 로 감.
+
+		MSG_ROOM_LIST,		// RoomListHeader + RoomSummary * roomCount.
+		MSG_ROOM_JOINED,	// 바디 int roomId. 바로 뒤에 MSG_ROOM_FULL_INFO 가 옴.
+		MSG_ROOM_LEFT,		// 방에서 나와 로비로 돌아옴.
+		MSG_ROOM_REJECT,	// 방 만들기/들어가기 실패. 바디는 이유 문자열.
+		MSG_OBSTACLE_BATCH,	// 서버가 장애물을 정할때만. ObstacleBatchHeader + Obstacle * count.
+		MSG_PROTOCOL_OFFER,	// 접속 직후. 바디 int 서버가 아는 최고 버전. 모르는 클라는 무시하고 v1 로 계속 씀.
+		MSG_PROTOCOL_ACK,	// 바디 int 정해진 버전. v1 으로 오고, 이 다음 메시지부터 서버가 그 버전으로 보냄.
+		MSG_WORLD_SNAPSHOT_PACKED,	// v3 클라에게 MSG_WORLD_SNAPSHOT 대신. 비트 단위로 줄인 스냅샷.
+		MSG_WORLD_SNAPSHOT_DELTA,	// v4 이상 클라에게. 클라가 받았다고 한 스냅샷에서 바뀐 값만.
+		MSG_END
+	};
+}
+
+#pragma pack(push, 1)
+struct MessageHeader
+{
+	int senderId;
+	int msgType;
+	int bodyLen;
+};
+#pragma pack(pop)
+
+// MSG_WORLD_SNAPSHOT 의 플레이어별 상태 비트.
+namespace EPlayerSnapshotFlag
+{
+	enum Type
+	{
+		Alive = 1 << 0,
+		Stun = 1 << 1,
+		Protection = 1 << 2,
+		Boost = 1 << 3,
+		MovingUp = 1 << 4
+	};
+}
+
+// MSG_WORLD_SNAPSHOT 바디.
+// WorldSnapshotHeader 뒤에 PlayerSnapshot 이 playerCount 만큼 붙음.
+#pragma pack(push, 1)
+struct WorldSnapshotHeader
+{
+	int tick;
+	int playerCount;
+};
+
+struct PlayerSnapshot
+{
+	int id;
+	float distance;
+	float height;
+	float hp;
+	unsigned char flags;
+};
+#pragma pack(pop)
+
+// MSG_START_ACK 바디. 시작을 못했으면 courseSeed 는 0.
+// MSG_OBSTACLE 바디는 Obstacle 하나.
+#pragma pack(push, 1)
+struct StartAck
+{
+	int readyFlag;
+	unsigned int courseSeed;	// 장애물 코스 시드. ObstacleCourse.h 참고.
+};
+
+struct Obstacle
+{
+	float scale;
+	float rotation;
+	float height;
+};
+
+// MSG_TAKE_DAMAGE 바디. tick 은 클라가 박았을때 보고 있던 스냅샷 틱, step 은 박은 장애물 칸.
+// 예전 클라는 float 하나만 보내는데 그때는 서버의 최신 상태로 확인함.
+struct CollisionReport
+{
+	int tick;
+	int step;
+};
+
+// MSG_OBSTACLE_BATCH 바디. firstStep 부터 연속된 count 칸.
+struct ObstacleBatchHeader
+{
+	int firstStep;
+	int count;
+};
+#pragma pack(pop)
+
+// MSG_ROOM_LIST 바디.
+#pragma pack(push, 1)
+struct RoomListHeader
+{
+	int roomCount;
+};
+
+struct RoomSummary
+{
+	int roomId;
+	int playerCount;
+	int maxPlayers;
+	int state;	// 0 대기, 1 게임중
+	int mapId;
+};
+#pragma pack(pop)
+
+// MSG_UDP_OFFER 바디.
+#pragma pack(push, 1)
+struct UdpOffer
+{
+	unsigned short port;
+	unsigned int token;
+};
+
+// MSG_PICK_ITEM 바디. 클라 -> 서버, 서버 -> 클라 같은 모양.
+struct PickItem
+{
+	int slot;
+	int itemId;
+};
+
+// MSG_TAKEN_DAMAGE 바디. 박은 플레이어와 남은 HP.
+struct TakenDamage
+{
+	int id;
+	float hp;
+};
+
+// v4 클라가 하트비트/입력 바디에 붙이는 마지막으로 복원한 스냅샷 번호.
+struct SnapshotAck
+{
+	unsigned int seq;
+};
+
+// MSG_ROOM_FULL_INFO 바디. RoomFullInfoHeader 뒤에 RoomPlayerInfo 가 playerCount 만큼.
+struct RoomFullInfoHeader
+{
+	int ownerId;
+	int mapId;
+	int playerCount;
+};
+
+struct RoomPlayerInfo
+{
+	int id;
+	bool isReady;
+	int characterId;
+	int itemSlots[3];
+};
+#pragma pack(pop)
+
+// 바디 모양. 메시지마다 하나씩 아래에서 정함.
+namespace EBodyLayout
+{
+	enum Type
+	{
+		Empty,	// 바디 없음.
+		Fixed,	// 구조체 하나. altSize 가 있으면 그 크기도 받음 (예전 클라나 생략 가능한 바디).
+		Array,	// 앞 구조체 안의 int 원소 수만큼 원소 구조체가 붙음.
+		Text,	// 0 으로 끝나는 문자열.
+		Bits	// CBitReader 로 읽는 가변 길이. 읽는 쪽이 끝을 확인함.
+	};
+}
+
+// 메시지 하나의 바디 규칙. 메시지 번호로 바로 찾는 표에 들어감.
+struct FBodyRule
+{
+	EBodyLayout::Type layout;
+	int size;			// Fixed 면 바디 크기, Array 면 앞 구조체 크기.
+	int altSize;		// Fixed 일때 같이 받아주는 크기. 없으면 -1.
+	int elemSize;		// Array 원소 크기.
+	int countOffset;	// Array 앞 구조체 안의 원소 수 위치.
+};
+
+template<int Msg>
+struct TEmptyBody
+{
+	enum { Type = Msg };
+	static constexpr FBodyRule Rule() { return FBodyRule{ EBodyLayout::Empty, 0, -1, 0, 0 }; }
+};
+
+// IsEmptyAllowed 면 바디 없이도 보낼 수 있음.
+template<int Msg, typename BodyT, bool IsEmptyAllowed = false, int AltSize = -1>
+struct TFixedBody
+{
+	static_assert(std::is_trivially_copyable<BodyT>::value, "fixed body must be memcpy-able");
+	static_assert(!IsEmptyAllowed || AltSize < 0, "only one alternative size");
+
+	enum { Type = Msg };
+	typedef BodyT Body;
+	static constexpr FBodyRule Rule() { return FBodyRule{ EBodyLayout::Fixed, (int)sizeof(BodyT), IsEmptyAllowed ? 0 : AltSize, 0, 0 }; }
+};
+
+template<int Msg, typename HeaderT, typename ElemT, size_t CountOffset>
+struct TArrayBody
+{
+	static_assert(std::is_trivially_copyable<HeaderT>::value && std::is_trivially_copyable<ElemT>::value, "array body must be memcpy-able");
+	static_assert(CountOffset + sizeof(int) <= sizeof(HeaderT), "count must be inside the header");
+
+	enum { Type = Msg };
+	typedef HeaderT Header;
+	typedef ElemT Elem;
+	static constexpr FBodyRule Rule() { return FBodyRule{ EBodyLayout::Array, (int)sizeof(HeaderT), -1, (int)sizeof(ElemT), (int)CountOffset }; }
+};
+
+template<int Msg>
+struct TTextBody
+{
+	enum { Type = Msg };
+	static constexpr FBodyRule Rule() { return FBodyRule{ EBodyLayout::Text, 0, -1, 0, 0 }; }
+};
+
+template<int Msg>
+struct TBitsBody
+{
+	enum { Type = Msg };
+	static constexpr FBodyRule Rule() { return FBodyRule{ EBodyLayout::Bits, 0, -1, 0, 0 }; }
+};
+
+// 방향마다 메시지 번호로 특수화함. 정하지 않은 메시지가 있으면 규칙 표를 만들때 컴파일이 안 됨.
+template<int Msg> struct TClientSchema;
+template<int Msg> struct TServerSchema;
+
+#define DECLARE_CLIENT_SCHEMA(Msg, ...) \
+	template<> struct TClientSchema<ClientMessage::Msg> : __VA_ARGS__ {}
+#define DECLARE_SERVER_SCHEMA(Msg, ...) \
+	template<> struct TServerSchema<ServerMessage::Msg> : __VA_ARGS__ {}
+
+DECLARE_CLIENT_SCHEMA(MSG_HEARTBEAT, TFixedBody<ClientMessage::MSG_HEARTBEAT, SnapshotAck, true>);
+DECLARE_CLIENT_SCHEMA(MSG_START, TEmptyBody<ClientMessage::MSG_START>);
+DECLARE_CLIENT_SCHEMA(MSG_PICK_CHARACTER, TFixedBody<ClientMessage::MSG_PICK_CHARACTER, int>);
+DECLARE_CLIENT_SCHEMA(MSG_PICK_ITEM, TFixedBody<ClientMessage::MSG_PICK_ITEM, PickItem>);
+DECLARE_CLIENT_SCHEMA(MSG_PICK_MAP, TFixedBody<ClientMessage::MSG_PICK_MAP, int>);
+DECLARE_CLIENT_SCHEMA(MSG_READY, TEmptyBody<ClientMessage::MSG_READY>);
+DECLARE_CLIENT_SCHEMA(MSG_UNREADY, TEmptyBody<ClientMessage::MSG_UNREADY>);
+DECLARE_CLIENT_SCHEMA(MSG_MOVE_UP, TFixedBody<ClientMessage::MSG_MOVE_UP, SnapshotAck, true>);
+DECLARE_CLIENT_SCHEMA(MSG_MOVE_DOWN, TFixedBody<ClientMessage::MSG_MOVE_DOWN, SnapshotAck, true>);
+DECLARE_CLIENT_SCHEMA(MSG_TAKE_DAMAGE, TFixedBody<ClientMessage::MSG_TAKE_DAMAGE, CollisionReport, false, sizeof(float)>);
+DECLARE_CLIENT_SCHEMA(MSG_BOOST_ON, TEmptyBody<ClientMessage::MSG_BOOST_ON>);
+DECLARE_CLIENT_SCHEMA(MSG_BOOST_OFF, TEmptyBody<ClientMessage::MSG_BOOST_OFF>);
+DECLARE_CLIENT_SCHEMA(MSG_ROOM_LIST, TEmptyBody<ClientMessage::MSG_ROOM_LIST>);
+DECLARE_CLIENT_SCHEMA(MSG_CREATE_ROOM, TEmptyBody<ClientMessage::MSG_CREATE_ROOM>);
+DECLARE_CLIENT_SCHEMA(MSG_JOIN_ROOM, TFixedBody<ClientMessage::MSG_JOIN_ROOM, int, true>);
+DECLARE_CLIENT_SCHEMA(MSG_LEAVE_ROOM, TEmptyBody<ClientMessage::MSG_LEAVE_ROOM>);
+DECLARE_CLIENT_SCHEMA(MSG_PROTOCOL_HELLO, TFixedBody<ClientMessage::MSG_PROTOCOL_HELLO, int>);
+
+DECLARE_SERVER_SCHEMA(MSG_CONNECTED, TFixedBody<ServerMessage::MSG_CONNECTED, int>);
+DECLARE_SERVER_SCHEMA(MSG_ROOM_FULL_INFO, TArrayBody<ServerMessage::MSG_ROOM_FULL_INFO, RoomFullInfoHeader, RoomPlayerInfo, offsetof(RoomFullInfoHeader, playerCount)>);
+DECLARE_SERVER_SCHEMA(MSG_DISCONNECT, TFixedBody<ServerMessage::MSG_DISCONNECT, int>);
+DECLARE_SERVER_SCHEMA(MSG_CONNECTED_REJECT, TTextBody<ServerMessage::MSG_CONNECTED_REJECT>);
+DECLARE_SERVER_SCHEMA(MSG_NEW_OWNER, TFixedBody<ServerMessage::MSG_NEW_OWNER, int>);
+DECLARE_SERVER_SCHEMA(MSG_JOIN, TFixedBody<ServerMessage::MSG_JOIN, int>);
+DECLARE_SERVER_SCHEMA(MSG_PICK_MAP, TFixedBody<ServerMessage::MSG_PICK_MAP, int>);
+DECLARE_SERVER_SCHEMA(MSG_PICK_ITEM, TFixedBody<ServerMessage::MSG_PICK_ITEM, PickItem>);
+DECLARE_SERVER_SCHEMA(MSG_PICK_CHARACTER, TFixedBody<ServerMessage::MSG_PICK_CHARACTER, int>);
+DECLARE_SERVER_SCHEMA(MSG_READY, TEmptyBody<ServerMessage::MSG_READY>);
+DECLARE_SERVER_SCHEMA(MSG_UNREADY, TEmptyBody<ServerMessage::MSG_UNREADY>);
+DECLARE_SERVER_SCHEMA(MSG_START_ACK, TFixedBody<ServerMessage::MSG_START_ACK, StartAck>);
+DECLARE_SERVER_SCHEMA(MSG_COUNTDOWN_FINISHED, TEmptyBody<ServerMessage::MSG_COUNTDOWN_FINISHED>);
+DECLARE_SERVER_SCHEMA(MSG_PLAYER_DEAD, TEmptyBody<ServerMessage::MSG_PLAYER_DEAD>);
+DECLARE_SERVER_SCHEMA(MSG_GAME_OVER, TTextBody<ServerMessage::MSG_GAME_OVER>);
+DECLARE_SERVER_SCHEMA(MSG_MOVE_UP, TEmptyBody<ServerMessage::MSG_MOVE_UP>);
+DECLARE_SERVER_SCHEMA(MSG_MOVE_DOWN, TEmptyBody<ServerMessage::MSG_MOVE_DOWN>);
+DECLARE_SERVER_SCHEMA(MSG_PLAYER_DISTANCE, TFixedBody<ServerMessage::MSG_PLAYER_DISTANCE, float>);
+DECLARE_SERVER_SCHEMA(MSG_PLAYER_HEIGHT, TFixedBody<ServerMessage::MSG_PLAYER_HEIGHT, float>);
+DECLARE_SERVER_SCHEMA(MSG_TAKEN_DAMAGE, TFixedBody<ServerMessage::MSG_TAKEN_DAMAGE, TakenDamage>);
+DECLARE_SERVER_SCHEMA(MSG_TAKEN_STUN, TEmptyBody<ServerMessage::MSG_TAKEN_STUN>);
+DECLARE_SERVER_SCHEMA(MSG_BOOST_ON, TEmptyBody<ServerMessage::MSG_BOOST_ON>);
+DECLARE_SERVER_SCHEMA(MSG_BOOST_OFF, TEmptyBody<ServerMessage::MSG_BOOST_OFF>);
+DECLARE_SERVER_SCHEMA(MSG_OBSTACLE, TFixedBody<ServerMessage::MSG_OBSTACLE, Obstacle>);
+DECLARE_SERVER_SCHEMA(MSG_HEARTBEAT_ACK, TEmptyBody<ServerMessage::MSG_HEARTBEAT_ACK>);
+DECLARE_SERVER_SCHEMA(MSG_WORLD_SNAPSHOT, TArrayBody<ServerMessage::MSG_WORLD_SNAPSHOT, WorldSnapshotHeader, PlayerSnapshot, offsetof(WorldSnapshotHeader, playerCount)>);
+DECLARE_SERVER_SCHEMA(MSG_UDP_OFFER, TFixedBody<ServerMessage::MSG_UDP_OFFER, UdpOffer>);
+DECLARE_SERVER_SCHEMA(MSG_UDP_READY, TEmptyBody<ServerMessage::MSG_UDP_READY>);
+DECLARE_SERVER_SCHEMA(MSG_ROOM_LIST, TArrayBody<ServerMessage::MSG_ROOM_LIST, RoomListHeader, RoomSummary, offsetof(RoomListHeader, roomCount)>);
+DECLARE_SERVER_SCHEMA(MSG_ROOM_JOINED, TFixedBody<ServerMessage::MSG_ROOM_JOINED, int>);
+DECLARE_SERVER_SCHEMA(MSG_ROOM_LEFT, TEmptyBody<ServerMessage::MSG_ROOM_LEFT>);
+DECLARE_SERVER_SCHEMA(MSG_ROOM_REJECT, TTextBody<ServerMessage::MSG_ROOM_REJECT>);
+DECLARE_SERVER_SCHEMA(MSG_OBSTACLE_BATCH, TArrayBody<ServerMessage::MSG_OBSTACLE_BATCH, ObstacleBatchHeader, Obstacle, offsetof(ObstacleBatchHeader, count)>);
+DECLARE_SERVER_SCHEMA(MSG_PROTOCOL_OFFER, TFixedBody<ServerMessage::MSG_PROTOCOL_OFFER, int>);
+DECLARE_SERVER_SCHEMA(MSG_PROTOCOL_ACK, TFixedBody<ServerMessage::MSG_PROTOCOL_ACK, int>);
+DECLARE_SERVER_SCHEMA(MSG_WORLD_SNAPSHOT_PACKED, TBitsBody<ServerMessage::MSG_WORLD_SNAPSHOT_PACKED>);
+DECLARE_SERVER_SCHEMA(MSG_WORLD_SNAPSHOT_DELTA, TBitsBody<ServerMessage::MSG_WORLD_SNAPSHOT_DELTA>);
+
+// 메시지 번호 순서대로 규칙을 펼친 표. 컴파일때 다 정해짐.
+template<template<int> class Schema, size_t... Msg>
+constexpr std::array<FBodyRule, sizeof...(Msg)> MakeBodyRuleTable(std::index_sequence<Msg...>)
+{
+	return std::array<FBodyRule, sizeof...(Msg)>{ { Schema<(int)Msg>::Rule()... } };
+}
+
+inline const FBodyRule* FindClientBodyRule(int msgType)
+{
+	static const std::array<FBodyRule, ClientMessage::MSG_END> table =
+		MakeBodyRuleTable<TClientSchema>(std::make_index_sequence<ClientMessage::MSG_END>());
+
+	return (msgType >= 0 && msgType < ClientMessage::MSG_END) ? &table[msgType] : nullptr;
+}
+
+inline const FBodyRule* FindServerBodyRule(int msgType)
+{
+	static const std::array<FBodyRule, ServerMessage::MSG_END> table =
+		MakeBodyRuleTable<TServerSchema>(std::make_index_sequence<ServerMessage::MSG_END>());
+
+	return (msgType >= 0 && msgType < ServerMessage::MSG_END) ? &table[msgType] : nullptr;
+}
+
+constexpr bool IsAllTrue(std::initializer_list<bool> values)
+{
+	for (bool value : values)
+	{
+		if (!value)
+			return false;
+	}
+
+	return true;
+}
+
+// 메시지 번호 순서대로 받는 쪽 처리 함수를 펼친 표. 받을때 번호로 바로 찾음.
+// Route<Msg>::Handle 을 정하지 않은 메시지가 있거나 스키마가 다른 번호로 선언돼 있으면 컴파일이 안 됨.
+template<template<int> class Schema, template<int> class Route, typename Fn, size_t... Msg>
+std::array<Fn, sizeof...(Msg)> MakeHandlerTable(std::index_sequence<Msg...>)
+{
+	static_assert(IsAllTrue({ Schema<(int)Msg>::Type == (int)Msg... }), "schema must use its own message number");
+	return std::array<Fn, sizeof...(Msg)>{ { &Route<(int)Msg>::Handle... } };
+}
+
+// 바디 길이가 규칙에 맞는지. Array 는 원소 수까지 맞아야 함.
+inline bool IsValidBody(const FBodyRule& rule, const char* body, int len)
+{
+	switch (rule.layout)
+	{
+	case EBodyLayout::Empty:
+		return len == 0;
+
+	case EBodyLayout::Fixed:
+		return len == rule.size || (rule.altSize >= 0 && len == rule.altSize);
+
+	case EBodyLayout::Array:
+	{
+		if (len < rule.size)
+			return false;
+
+		int count;
+		memcpy(&count, body + rule.countOffset, sizeof(int));
+
+		return count >= 0 && count <= (len - rule.size) / rule.elemSize
+			&& len == rule.size + count * rule.elemSize;
+	}
+
+	case EBodyLayout::Text:
+		return len > 0 && body[len - 1] == '\0';
+
+	case EBodyLayout::Bits:
+		return true;
+	}
+
+	return false;
+}
+
+// 모르는 메시지 번호도 false.
+inline bool IsValidClientBody(int msgType, const char* body, int len)
+{
+	const FBodyRule* rule = FindClientBodyRule(msgType);
+	return rule && IsValidBody(*rule, body, len);
+}
+
+inline bool IsValidServerBody(int msgType, const char* body, int len)
+{
+	const FBodyRule* rule = FindServerBodyRule(msgType);
+	return rule && IsValidBody(*rule, body, len);
+}
+
+// 고정 크기 바디를 꺼냄. 크기가 다르면 (생략됐거나 예전 크기면) false.
+template<typename Schema>
+inline bool DecodeBody(const char* body, int len, typename Schema::Body& out)
+{
+	if (len != (int)sizeof(out))
+		return false;
+
+	memcpy(&out, body, sizeof(out));
+	return true;
+}
+
+// Array 바디의 앞 구조체와 원소. 길이는 IsValidBody 로 확인한 뒤에 씀.
+template<typename Schema>
+inline typename Schema::Header DecodeArrayHeader(const char* body)
+{
+	typename Schema::Header header;
+	memcpy(&header, body, sizeof(header));
+	return header;
+}
+
+template<typename Schema>
+inline typename Schema::Elem DecodeArrayElem(const char* body, int index)
+{
+	typename Schema::Elem elem;
+	memcpy(&elem, body + sizeof(typename Schema::Header) + sizeof(elem) * index, sizeof(elem));
+	return elem;
+}
+
+// Array 바디를 out 에 씀. elems 는 header 의 원소 수만큼.
+template<typename Schema>
+inline void EncodeArrayBody(std::vector<char>& out, const typename Schema::Header& header, const typename Schema::Elem* elems, int count)
+{
+	out.resize(sizeof(header) + sizeof(*elems) * count);
+	memcpy(out.data(), &header, sizeof(header));
+	if (count > 0)
+		memcpy(out.data() + sizeof(header), elems, sizeof(*elems) * count);
+}
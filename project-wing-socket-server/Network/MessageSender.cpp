@@ -0,0 +1,25 @@
+﻿#include "Network/MessageSender.h"
+#include "Network/UdpChannel.h"
+
+DEFINITION_SINGLE(CMessageSender);
+
+CMessageSender::CMessageSender()
+{
+
+}
+
+CMessageSender::~CMessageSender()
+{
+
+}
+
+void CMessageSender::Send(Connection* conn, const FramePtr& frame)
+{
+	if (!CUdpChannel::GetInst()->Send(conn, frame))
+		mNetwork->Enqueue(conn, frame);
+}
+
+void CMessageSender::Send(Connection* conn, int senderId, int msgType, const void* body, int bodyLen)
+{
+	Send(conn, MakeFrame(senderId, msgType, body, bodyLen));
+}
@@ -0,0 +1,28 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Interface/INetworkBackend.h"
+
+// 게임 코드가 메시지를 보낼때 쓰는 곳.
+// UDP 세션이 묶여 있고 UDP 로 보내는 종류면 UDP 로, 아니면 TCP 송신 큐로.
+class CMessageSender
+{
+private:
+	INetworkBackend* mNetwork = nullptr;
+
+public:
+	inline void Init(INetworkBackend* network) { mNetwork = network; }
+	inline INetworkBackend* GetNetwork() const { return mNetwork; }
+
+	void Send(Connection* conn, const FramePtr& frame);
+	void Send(Connection* conn, int senderId, int msgType, const void* body, int bodyLen);
+
+	// 고정 크기 바디. 메시지 번호와 바디 타입을 MessageSchema.h 의 선언에서 가져옴.
+	template<typename Schema>
+	void Send(Connection* conn, int senderId, const typename Schema::Body& body)
+	{
+		Send(conn, senderId, (int)Schema::Type, &body, (int)sizeof(body));
+	}
+
+	DECLARE_SINGLE(CMessageSender);
+};
@@ -0,0 +1,352 @@
+﻿#include "Network/NetworkReactor.h"
+
+DEFINITION_SINGLE(CNetworkReactor);
+
+// 지금 스레드가 맡고 있는 I/O 스레드 정보. I/O 스레드가 아니면 nullptr.
+static thread_local const void* tCurrentIoThread = nullptr;
+
+CNetworkReactor::CNetworkReactor()
+{
+
+}
+
+CNetworkReactor::~CNetworkReactor()
+{
+
+}
+
+bool CNetworkReactor::Init(int ioThreadCount, MessageCallback onMessage, DisconnectCallback onDisconnect)
+{
+	mOnMessage = std::move(onMessage);
+	mOnDisconnect = std::move(onDisconnect);
+
+	for (int i = 0; i < ioThreadCount; i++)
+	{
+		FIoThread* io = new FIoThread;
+		io->index = i;
+
+		if (!CreateWakeSocket(io))
+		{
+			std::cout << "[Reactor] CreateWakeSocket failed: " << WSAGetLastError() << "\n";
+			delete io;
+			return false;
+		}
+
+		mIoThreads.push_back(io);
+	}
+
+	for (auto& io : mIoThreads)
+	{
+		io->thread = std::thread(&CNetworkReactor::IoThreadLoop, this, io);
+		io->thread.detach();
+	}
+
+	std::cout << "[Reactor] I/O threads: " << ioThreadCount << "\n";
+	return true;
+}
+
+void CNetworkReactor::AddConnection(Connection* conn)
+{
+	u_long nonBlocking = 1;
+	ioctlsocket(conn->sock, FIONBIO, &nonBlocking);
+
+	FIoThread* io = mIoThreads[mNextIoThread++ % mIoThreads.size()];
+	conn->ioThreadIndex = io->index;
+
+	{
+		std::lock_guard<std::mutex> lock(io->pendingMutex);
+		io->pendingConnections.push_back(conn);
+	}
+
+	Wake(io);
+}
+
+bool CNetworkReactor::StartAccept(SOCKET listenSock, AcceptCallback onAccept)
+{
+	mOnAccept = std::move(onAccept);
+
+	u_long nonBlocking = 1;
+	ioctlsocket(listenSock, FIONBIO, &nonBlocking);
+
+	// accept 는 0번 I/O 스레드가 같이 맡음.
+	FIoThread* io = mIoThreads[0];
+
+	{
+		std::lock_guard<std::mutex> lock(io->pendingMutex);
+		io->pendingListenSock = listenSock;
+	}
+
+	Wake(io);
+	return true;
+}
+
+void CNetworkReactor::Enqueue(Connection* conn, const FramePtr& frame)
+{
+	std::lock_guard<std::mutex> lock(conn->ioMutex);
+
+	// 이미 닫았는데 샤드 쪽이 아직 모르고 보내는 경우.
+	if (conn->isClosed)
+		return;
+
+	// 끊기로 한 연결도 I/O 스레드가 정리하도록 깨워줌.
+	if (!QueueFrame(conn, frame) && !conn->isEvicted)
+		return;
+
+	conn->wantWrite = true;
+	mIoThreads[conn->ioThreadIndex]->isFlushRequested = true;
+}
+
+void CNetworkReactor::Flush()
+{
+	// 실제 송신은 연결을 맡은 I/O 스레드가 함. 여기선 깨우기만.
+	for (auto& io : mIoThreads)
+	{
+		if (!io->isFlushRequested.exchange(false))
+			continue;
+
+		// 자기 자신이면 루프 처음으로 돌아가면서 어차피 보냄.
+		if (io != tCurrentIoThread)
+			Wake(io);
+	}
+}
+
+// ioMutex 잡은 상태로 호출.
+// 쌓인 프레임들을 WSASend 한번으로 묶어서 소켓이 받아주는 만큼 보내고 나머지는 남겨둠.
+bool CNetworkReactor::FlushSendQueue(Connection* conn)
+{
+	while (!conn->sendQueue.empty())
+	{
+		WSABUF bufs[SEND_GATHER_MAX];
+		size_t totalBytes = 0;
+		DWORD bufCount = BuildSendBuffers(conn, bufs, SEND_GATHER_MAX, totalBytes);
+
+		DWORD sent = 0;
+		if (WSASend(conn->sock, bufs, bufCount, &sent, 0, nullptr, nullptr) == SOCKET_ERROR)
+		{
+			if (WSAGetLastError() != WSAEWOULDBLOCK)
+				return false;
+
+			conn->isWriteBlocked = true;
+			break;
+		}
+
+		ConsumeSendQueue(conn, sent);
+
+		// 덜 나갔으면 송신 버퍼가 찬 것.
+		if (sent < totalBytes)
+		{
+			conn->isWriteBlocked = true;
+			break;
+		}
+	}
+
+	conn->wantWrite = !conn->sendQueue.empty();
+	return true;
+}
+
+bool CNetworkReactor::WriteConnection(Connection* conn)
+{
+	std::lock_guard<std::mutex> lock(conn->ioMutex);
+	return FlushSendQueue(conn);
+}
+
+bool CNetworkReactor::CreateWakeSocket(FIoThread* io)
+{
+	io->wakeSock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (io->wakeSock == INVALID_SOCKET)
+		return false;
+
+	io->wakeAddr.sin_family = AF_INET;
+	io->wakeAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	io->wakeAddr.sin_port = 0;
+
+	if (bind(io->wakeSock, (sockaddr*)&io->wakeAddr, sizeof(io->wakeAddr)) == SOCKET_ERROR)
+		return false;
+
+	// 포트는 OS 가 골라준걸 다시 읽어옴.
+	int addrLen = sizeof(io->wakeAddr);
+	if (getsockname(io->wakeSock, (sockaddr*)&io->wakeAddr, &addrLen) == SOCKET_ERROR)
+		return false;
+
+	u_long nonBlocking = 1;
+	ioctlsocket(io->wakeSock, FIONBIO, &nonBlocking);
+	return true;
+}
+
+void CNetworkReactor::Wake(FIoThread* io)
+{
+	char signal = 0;
+	sendto(io->wakeSock, &signal, 1, 0, (sockaddr*)&io->wakeAddr, sizeof(io->wakeAddr));
+}
+
+void CNetworkReactor::DrainWakeSocket(FIoThread* io)
+{
+	char buffer[64];
+	while (recvfrom(io->wakeSock, buffer, sizeof(buffer), 0, nullptr, nullptr) > 0) {}
+}
+
+void CNetworkReactor::IoThreadLoop(FIoThread* io)
+{
+	tCurrentIoThread = io;
+
+	while (true)
+	{
+		// 새로 붙은 연결 편입.
+		{
+			std::lock_guard<std::mutex> lock(io->pendingMutex);
+			for (auto& conn : io->pendingConnections)
+				io->connections.push_back(conn);
+			io->pendingConnections.clear();
+
+			if (io->pendingListenSock != INVALID_SOCKET)
+			{
+				io->listenSock = io->pendingListenSock;
+				io->pendingListenSock = INVALID_SOCKET;
+			}
+		}
+
+		// 쌓인 송신부터 내보냄. 송신 버퍼가 찬 연결은 쓰기 가능 이벤트를 기다림.
+		for (size_t i = io->connections.size(); i-- > 0;)
+		{
+			Connection* conn = io->connections[i];
+
+			if (!conn->isEvicted)
+			{
+				if (!conn->wantWrite || conn->isWriteBlocked)
+					continue;
+
+				if (WriteConnection(conn))
+					continue;
+			}
+
+			io->connections[i] = io->connections.back();
+			io->connections.pop_back();
+			CloseConnection(conn);
+		}
+
+		// [0] 깨우기용, [1] 리슨 소켓(있으면), 그 뒤로 연결들.
+		size_t fixedCount = (io->listenSock != INVALID_SOCKET) ? 2 : 1;
+
+		io->pollFds.resize(io->connections.size() + fixedCount);
+		io->pollFds[0] = { io->wakeSock, POLLRDNORM, 0 };
+
+		if (io->listenSock != INVALID_SOCKET)
+			io->pollFds[1] = { io->listenSock, POLLRDNORM, 0 };
+
+		for (size_t i = 0; i < io->connections.size(); i++)
+		{
+			Connection* conn = io->connections[i];
+			short events = POLLRDNORM;
+
+			if (conn->isWriteBlocked)
+				events |= POLLWRNORM;
+
+			io->pollFds[i + fixedCount] = { conn->sock, events, 0 };
+		}
+
+		int ready = WSAPoll(io->pollFds.data(), (ULONG)io->pollFds.size(), -1);
+
+		if (ready == SOCKET_ERROR)
+		{
+			std::cout << "[Reactor] WSAPoll failed: " << WSAGetLastError() << "\n";
+			continue;
+		}
+
+		if (io->pollFds[0].revents != 0)
+			DrainWakeSocket(io);
+
+		if (fixedCount > 1 && io->pollFds[1].revents != 0)
+			AcceptConnections(io->listenSock);
+
+		// 뒤에서부터 돌아야 끊긴 연결을 swap 으로 빼도 앞쪽 인덱스가 안 꼬임.
+		for (size_t i = io->connections.size(); i-- > 0;)
+		{
+			short revents = io->pollFds[i + fixedCount].revents;
+			if (revents == 0)
+				continue;
+
+			Connection* conn = io->connections[i];
+			bool isAlive = true;
+
+			if (revents & POLLWRNORM)
+			{
+				conn->isWriteBlocked = false;
+				isAlive = WriteConnection(conn);
+			}
+
+			if (isAlive && (revents & ~POLLWRNORM))
+				isAlive = ReadConnection(conn);
+
+			if (isAlive)
+				continue;
+
+			io->connections[i] = io->connections.back();
+			io->connections.pop_back();
+			CloseConnection(conn);
+		}
+
+		// 이번에 처리한 메시지들이 쌓은 송신을 한번에 내보냄.
+		Flush();
+	}
+}
+
+void CNetworkReactor::AcceptConnections(SOCKET listenSock)
+{
+	while (true)
+	{
+		sockaddr_in clientAddr{};
+		int size = sizeof(clientAddr);
+		SOCKET clientSock = accept(listenSock, (sockaddr*)&clientAddr, &size);
+
+		if (clientSock == INVALID_SOCKET)
+			break;
+
+		mOnAccept(clientSock);
+	}
+}
+
+bool CNetworkReactor::ReadConnection(Connection* conn)
+{
+	// WSAPoll 은 레벨 트리거라서 한번 깨어났을때 소켓에 쌓인걸 최대한 다 읽어둠.
+	// 링의 빈 공간 전체를 한번에 넘겨서 보통은 WSARecv 한번으로 끝남.
+	while (true)
+	{
+		WSABUF bufs[2];
+		DWORD bufCount = conn->recvRing.GetWriteBuffers(bufs);
+		size_t freeBytes = conn->recvRing.GetFree();
+
+		DWORD received = 0;
+		DWORD flags = 0;
+
+		if (WSARecv(conn->sock, bufs, bufCount, &received, &flags, nullptr, nullptr) == SOCKET_ERROR)
+			return WSAGetLastError() == WSAEWOULDBLOCK;
+
+		if (received == 0)
+			return false;
+
+		conn->recvRing.Commit(received);
+
+		if (!DispatchMessages(conn))
+			return false;
+
+		// 덜 채워졌으면 소켓이 비었다는 뜻이라 다시 읽을 필요 없음.
+		if (received < freeBytes)
+			return true;
+	}
+}
+
+void CNetworkReactor::CloseConnection(Connection* conn)
+{
+	{
+		std::lock_guard<std::mutex> lock(conn->ioMutex);
+		conn->isClosed = true;
+		conn->sendQueue.clear();
+		conn->conflationSlots.clear();
+	}
+
+	mOnDisconnect(conn);
+	closesocket(conn->sock);
+
+	// 게임 쪽 정리가 샤드에서 끝나야 실제로 지워짐.
+	conn->Release();
+}
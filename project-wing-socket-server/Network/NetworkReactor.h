@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Interface/INetworkBackend.h"
+
+// 고정 개수의 I/O 스레드가 WSAPoll 로 모든 연결을 나눠서 감시함.
+// 클라이언트 하나당 스레드 하나씩 만들던 구조를 대체.
+// IOCP 를 못 쓸때의 기본 백엔드.
+class CNetworkReactor : public INetworkBackend
+{
+private:
+	struct FIoThread
+	{
+		int index = 0;
+		std::thread thread;
+
+		// 이 스레드 담당 연결에 새로 쌓인 송신이 있는지.
+		std::atomic<bool> isFlushRequested{ false };
+
+		// 대기중인 WSAPoll 을 깨우기 위한 루프백 UDP 소켓.
+		SOCKET wakeSock = INVALID_SOCKET;
+		sockaddr_in wakeAddr{};
+
+		std::mutex pendingMutex;
+		std::vector<Connection*> pendingConnections;
+		SOCKET pendingListenSock = INVALID_SOCKET;
+
+		// 이 스레드에서만 접근함.
+		SOCKET listenSock = INVALID_SOCKET;
+		std::vector<Connection*> connections;
+		std::vector<WSAPOLLFD> pollFds;
+	};
+
+	std::vector<FIoThread*> mIoThreads;
+	std::atomic<unsigned int> mNextIoThread{ 0 };
+
+public:
+	virtual bool Init(int ioThreadCount, MessageCallback onMessage, DisconnectCallback onDisconnect) override;
+	virtual bool StartAccept(SOCKET listenSock, AcceptCallback onAccept) override;
+	virtual void AddConnection(Connection* conn) override;
+	virtual void Enqueue(Connection* conn, const FramePtr& frame) override;
+	virtual void Flush() override;
+	virtual const char* GetName() override { return "WSAPoll"; }
+
+private:
+	bool CreateWakeSocket(FIoThread* io);
+	void Wake(FIoThread* io);
+	void DrainWakeSocket(FIoThread* io);
+
+	void IoThreadLoop(FIoThread* io);
+	void AcceptConnections(SOCKET listenSock);
+	bool ReadConnection(Connection* conn);
+	bool WriteConnection(Connection* conn);
+	bool FlushSendQueue(Connection* conn);
+	void CloseConnection(Connection* conn);
+
+	DECLARE_SINGLE(CNetworkReactor);
+};
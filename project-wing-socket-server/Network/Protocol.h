@@ -0,0 +1,347 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Network/BitPacker.h"
+#include "Network/MessageSchema.h"
+
+// 최신 값만 의미 있는 상태 업데이트인지.
+// 송신이 밀리면 이런 메시지는 버려도 다음 값이 곧 다시 감.
+inline bool IsStateUpdateMessage(int msgType)
+{
+	switch (msgType)
+	{
+	case ServerMessage::MSG_PLAYER_DISTANCE:
+	case ServerMessage::MSG_PLAYER_HEIGHT:
+	case ServerMessage::MSG_WORLD_SNAPSHOT:
+	case ServerMessage::MSG_WORLD_SNAPSHOT_PACKED:
+	case ServerMessage::MSG_WORLD_SNAPSHOT_DELTA:
+		return true;
+	}
+
+	return false;
+}
+
+// 같은 보낸이의 이전 값을 새 값으로 덮어써도 되는 메시지인지.
+// 이벤트 메시지(사망, 시작 등)는 순서대로 다 가야 해서 해당 안 됨.
+inline bool IsConflatableMessage(int msgType)
+{
+	switch (msgType)
+	{
+	case ServerMessage::MSG_PLAYER_DISTANCE:
+	case ServerMessage::MSG_PLAYER_HEIGHT:
+	case ServerMessage::MSG_TAKEN_DAMAGE:
+	case ServerMessage::MSG_WORLD_SNAPSHOT:
+	case ServerMessage::MSG_WORLD_SNAPSHOT_PACKED:
+	case ServerMessage::MSG_WORLD_SNAPSHOT_DELTA:
+		return true;
+	}
+
+	return false;
+}
+
+// UDP 채널로 보낼때의 전달 방식.
+namespace EUdpDelivery
+{
+	enum Type : unsigned char
+	{
+		None,		// TCP 로만 보냄.
+		Unreliable,	// 순서 번호만 붙여서 보냄. 오래된건 받는 쪽이 버림.
+		Reliable	// ack 올때까지 재전송. 지금은 이걸로 보내는 메시지 없음.
+	};
+}
+
+// 서버 메시지를 UDP 세션이 있을때 어떻게 보낼지.
+// 사망, 스턴, 장애물 같은 게임 이벤트는 TCP 로 가는 게임 종료나 데미지와 순서가 섞이면 안 돼서
+// (종료 뒤에 사망이 오거나, 장애물보다 그 장애물에 맞은 데미지가 먼저 옴) 전부 TCP 로 보냄.
+// UDP 로는 늦거나 빠져도 다음 값이 덮는 상태만 보냄.
+inline EUdpDelivery::Type GetUdpDelivery(int msgType)
+{
+	switch (msgType)
+	{
+	case ServerMessage::MSG_WORLD_SNAPSHOT:
+	case ServerMessage::MSG_WORLD_SNAPSHOT_PACKED:
+	case ServerMessage::MSG_WORLD_SNAPSHOT_DELTA:
+	case ServerMessage::MSG_MOVE_UP:
+	case ServerMessage::MSG_MOVE_DOWN:
+		return EUdpDelivery::Unreliable;
+	}
+
+	return EUdpDelivery::None;
+}
+
+// 클라가 UDP 로 보내도 받아주는 메시지. 입력만 받음.
+inline bool IsUdpClientMessage(int msgType)
+{
+	return msgType == ClientMessage::MSG_MOVE_UP
+		|| msgType == ClientMessage::MSG_MOVE_DOWN;
+}
+
+// 바디 앞에 스냅샷 ack 를 붙여 보낼 수 있는 클라 메시지.
+inline bool IsSnapshotAckCarrier(int msgType)
+{
+	return msgType == ClientMessage::MSG_HEARTBEAT
+		|| msgType == ClientMessage::MSG_MOVE_UP
+		|| msgType == ClientMessage::MSG_MOVE_DOWN;
+}
+
+// 프레임 헤더 버전. TCP 연결마다 MSG_PROTOCOL_HELLO/ACK 로 정함. UDP 는 항상 v1.
+// v1: MessageHeader 그대로 12바이트.
+// v2: 타입 1바이트 + 바디 길이 varint + (타입의 최상위 비트가 켜져 있으면) 보낸이 varint.
+//     보낸이가 0 인 메시지는 보낸이를 안 붙임. 빈 MSG_MOVE_UP 이면 12바이트가 3바이트 정도로 줄어듦.
+// v3: v2 헤더 + 스냅샷을 MSG_WORLD_SNAPSHOT_PACKED 로 받음.
+// v4: v3 + 스냅샷을 MSG_WORLD_SNAPSHOT_DELTA 로 받고 하트비트/입력에 ack 를 붙임.
+#define PROTOCOL_VERSION_V1 1
+#define PROTOCOL_VERSION_V2 2
+#define PROTOCOL_VERSION_V3 3
+#define PROTOCOL_VERSION_V4 4
+#define PROTOCOL_VERSION_MAX PROTOCOL_VERSION_V4
+
+#define PROTOCOL_V2_SENDER_BIT 0x80
+#define PROTOCOL_V2_MAX_VARINT 5
+#define PROTOCOL_V2_MAX_HEADER (1 + PROTOCOL_V2_MAX_VARINT * 2)
+
+static_assert(ServerMessage::MSG_END <= PROTOCOL_V2_SENDER_BIT, "v2 message type must fit in 7 bits");
+static_assert(ClientMessage::MSG_END <= PROTOCOL_V2_SENDER_BIT, "v2 message type must fit in 7 bits");
+
+// 7비트씩 낮은 쪽부터. 이어지는 바이트가 있으면 최상위 비트를 켬.
+inline int WriteVarint(char* dest, unsigned int value)
+{
+	int len = 0;
+
+	while (value >= 0x80)
+	{
+		dest[len++] = (char)((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+
+	dest[len++] = (char)value;
+	return len;
+}
+
+// 읽은 바이트 수. 아직 덜 왔으면 0, 너무 길면 -1.
+inline int ReadVarint(const char* src, int len, unsigned int& out)
+{
+	out = 0;
+
+	for (int i = 0; i < PROTOCOL_V2_MAX_VARINT; i++)
+	{
+		if (i >= len)
+			return 0;
+
+		unsigned char b = (unsigned char)src[i];
+		out |= (unsigned int)(b & 0x7F) << (7 * i);
+
+		if (!(b & 0x80))
+			return i + 1;
+	}
+
+	return -1;
+}
+
+// dest 는 PROTOCOL_V2_MAX_HEADER 이상. 쓴 바이트 수를 돌려줌.
+inline int EncodeHeaderV2(char* dest, int senderId, int msgType, int bodyLen)
+{
+	bool hasSender = senderId != 0;
+	int len = 0;
+
+	dest[len++] = (char)((msgType & 0x7F) | (hasSender ? PROTOCOL_V2_SENDER_BIT : 0));
+	len += WriteVarint(dest + len, (unsigned int)bodyLen);
+
+	if (hasSender)
+		len += WriteVarint(dest + len, (unsigned int)senderId);
+
+	return len;
+}
+
+// 헤더 길이. 아직 덜 왔으면 0, 잘못된 헤더면 -1.
+inline int DecodeHeaderV2(const char* src, int len, MessageHeader& out)
+{
+	if (len < 1)
+		return 0;
+
+	unsigned char typeByte = (unsigned char)src[0];
+	int pos = 1;
+
+	unsigned int bodyLen = 0;
+	int read = ReadVarint(src + pos, len - pos, bodyLen);
+	if (read <= 0)
+		return read;
+	pos += read;
+
+	unsigned int senderId = 0;
+	if (typeByte & PROTOCOL_V2_SENDER_BIT)
+	{
+		read = ReadVarint(src + pos, len - pos, senderId);
+		if (read <= 0)
+			return read;
+		pos += read;
+	}
+
+	if (bodyLen > 0x7FFFFFFF)
+		return -1;
+
+	out.senderId = (int)senderId;
+	out.msgType = typeByte & 0x7F;
+	out.bodyLen = (int)bodyLen;
+	return pos;
+}
+
+// MSG_WORLD_SNAPSHOT_PACKED 바디. CBitWriter 로 이어 씀.
+//   tick (var), playerCount (SNAPSHOT_PACKED_COUNT_BITS)
+//   플레이어마다 id (var), flags (SNAPSHOT_PACKED_FLAG_BITS), height, distance, hp (각 스펙 비트)
+// 마지막에 바이트를 맞춤. 플레이어 하나가 17바이트에서 8바이트 정도로 줄어듦.
+#define SNAPSHOT_PACKED_COUNT_BITS 4
+#define SNAPSHOT_PACKED_FLAG_BITS 5
+
+// 높이는 화면 높이 720 을 가운데 0 기준으로. 1/8 픽셀.
+constexpr FQuantSpec SNAPSHOT_HEIGHT_SPEC = MakeQuantSpec(-360.0f, 360.0f, 0.125f);
+// 거리는 1/32 고정 소수점. 틱당 1 도 안 늘어서 몇시간을 달려도 안 넘침.
+constexpr FQuantSpec SNAPSHOT_DISTANCE_SPEC = MakeQuantSpec(0.0f, 65535.0f, 1.0f / 32.0f);
+// HP 는 0.1 단위. 캐릭터 표의 HP 는 100 근처.
+constexpr FQuantSpec SNAPSHOT_HP_SPEC = MakeQuantSpec(0.0f, 1000.0f, 0.1f);
+
+static_assert(SNAPSHOT_HEIGHT_SPEC.bits == 13, "height must pack into 13 bits");
+static_assert(SNAPSHOT_DISTANCE_SPEC.bits == 21, "distance must pack into 21 bits");
+static_assert(SNAPSHOT_HP_SPEC.bits == 14, "hp must pack into 14 bits");
+static_assert(IsQuantSpecTight(SNAPSHOT_HEIGHT_SPEC), "height round trip exceeds half a step");
+static_assert(IsQuantSpecTight(SNAPSHOT_DISTANCE_SPEC), "distance round trip exceeds half a step");
+static_assert(IsQuantSpecTight(SNAPSHOT_HP_SPEC), "hp round trip exceeds half a step");
+static_assert(EPlayerSnapshotFlag::MovingUp < (1 << SNAPSHOT_PACKED_FLAG_BITS), "snapshot flags must fit");
+
+// MSG_WORLD_SNAPSHOT_DELTA 바디. CBitWriter 로 이어 씀.
+//   seq (var), baselineSeq (var, 0 이면 기준 없이 전부), tick (var), isReckoning (1비트)
+//   sameRoster (1비트). 0 이면 playerCount (SNAPSHOT_PACKED_COUNT_BITS) + id (var) 를 순서대로.
+//   1 이면 기준 스냅샷과 같은 플레이어가 같은 순서.
+//   플레이어마다 바뀐 필드 비트 (SNAPSHOT_DELTA_FIELD_BITS), 켜진 필드만 PACKED 와 같은 비트로.
+//   isReckoning 이면 Height/Distance 뒤에 그 값을 정한 틱까지의 거리 (tick - 기준점 틱, var) 가 붙음.
+//   Stats 는 dex, speed 를 SNAPSHOT_STAT_SPEC 비트로.
+//   기준에 없던 플레이어는 모든 필드가 켜져서 옴.
+// 클라는 받은 스냅샷을 값 그대로 (줄인 칸 번호로) 기억해 두고, 기준으로 쓰인 스냅샷을 찾아 덮어써서 복원함.
+// 복원한 스냅샷의 seq 를 하트비트나 입력에 붙여 보내면 다음부터 그걸 기준으로 보냄.
+// 높이/거리는 항상 ExtrapolateHeight/ExtrapolateDistance 로 지금 틱까지 늘려서 씀.
+// isReckoning 이 아니면 기준점 틱이 항상 스냅샷 틱이라 값 그대로와 같음.
+namespace ESnapshotField
+{
+	enum Type
+	{
+		Flags = 1 << 0,
+		Height = 1 << 1,
+		Distance = 1 << 2,
+		Hp = 1 << 3,
+		Stats = 1 << 4,
+		All = Flags | Height | Distance | Hp | Stats
+	};
+}
+
+#define SNAPSHOT_DELTA_FIELD_BITS 5
+
+// 데드 레커닝 식의 틱 간격. 서버 TICK_RATE 와 같아야 함.
+#define SNAPSHOT_RECKON_TICK_RATE 60
+
+// 데드 레커닝 식의 부스트 배율. 서버 PLAYER_BOOST_MULTIPLIER 와 같아야 함.
+#define SNAPSHOT_RECKON_BOOST 2.0f
+
+// 캐릭터 dex, speed. 표의 값은 100, 700 근처.
+constexpr FQuantSpec SNAPSHOT_STAT_SPEC = MakeQuantSpec(0.0f, 4095.0f, 0.25f);
+static_assert(SNAPSHOT_STAT_SPEC.bits == 14, "stats must pack into 14 bits");
+static_assert(IsQuantSpecTight(SNAPSHOT_STAT_SPEC), "stat round trip exceeds half a step");
+
+// 줄인 칸 번호로 들고 있는 플레이어 상태. 같은지 비교는 이걸로 해야 양쪽이 어긋나지 않음.
+// 높이/거리는 heightTick/distanceTick 에 찍은 기준점이고, 지금 값은 거기서 늘려서 구함.
+struct FPackedPlayerState
+{
+	int id = 0;
+	unsigned int flags = 0;
+	unsigned int height = 0;
+	unsigned int distance = 0;
+	unsigned int hp = 0;
+	unsigned int dex = 0;
+	unsigned int speed = 0;
+	int heightTick = 0;
+	int distanceTick = 0;
+};
+
+inline FPackedPlayerState PackPlayerSnapshot(const PlayerSnapshot& player, int tick, float dex, float speed)
+{
+	FPackedPlayerState state;
+	state.id = player.id;
+	state.flags = player.flags;
+	state.height = Quantize(SNAPSHOT_HEIGHT_SPEC, player.height);
+	state.distance = Quantize(SNAPSHOT_DISTANCE_SPEC, player.distance);
+	state.hp = Quantize(SNAPSHOT_HP_SPEC, player.hp);
+	state.dex = Quantize(SNAPSHOT_STAT_SPEC, dex);
+	state.speed = Quantize(SNAPSHOT_STAT_SPEC, speed);
+	state.heightTick = tick;
+	state.distanceTick = tick;
+	return state;
+}
+
+inline int DiffPackedPlayer(const FPackedPlayerState& from, const FPackedPlayerState& to)
+{
+	int mask = 0;
+	if (from.flags != to.flags) mask |= ESnapshotField::Flags;
+	if (from.height != to.height || from.heightTick != to.heightTick) mask |= ESnapshotField::Height;
+	if (from.distance != to.distance || from.distanceTick != to.distanceTick) mask |= ESnapshotField::Distance;
+	if (from.hp != to.hp) mask |= ESnapshotField::Hp;
+	if (from.dex != to.dex || from.speed != to.speed) mask |= ESnapshotField::Stats;
+	return mask;
+}
+
+// 서버 CPlayerSim::Step 과 같은 식. 살아있고 스턴이 아니면 매 틱 같은 만큼 움직임.
+// 플래그가 바뀌면 서버가 기준점을 새로 찍어서 보내므로 그 사이에는 항상 직선.
+inline bool IsReckonMoving(const FPackedPlayerState& state)
+{
+	return (state.flags & EPlayerSnapshotFlag::Alive) && !(state.flags & EPlayerSnapshotFlag::Stun);
+}
+
+inline float ExtrapolateHeight(const FPackedPlayerState& state, int tick)
+{
+	float height = Dequantize(SNAPSHOT_HEIGHT_SPEC, state.height);
+	if (!IsReckonMoving(state))
+		return height;
+
+	float dir = (state.flags & EPlayerSnapshotFlag::MovingUp) ? 1.0f : -1.0f;
+	float perTick = Dequantize(SNAPSHOT_STAT_SPEC, state.dex) / SNAPSHOT_RECKON_TICK_RATE * dir;
+	return clamp(height + perTick * (tick - state.heightTick), SNAPSHOT_HEIGHT_SPEC.minValue, SNAPSHOT_HEIGHT_SPEC.maxValue);
+}
+
+inline float ExtrapolateDistance(const FPackedPlayerState& state, int tick)
+{
+	float distance = Dequantize(SNAPSHOT_DISTANCE_SPEC, state.distance);
+	if (!IsReckonMoving(state))
+		return distance;
+
+	float boost = (state.flags & EPlayerSnapshotFlag::Boost) ? SNAPSHOT_RECKON_BOOST : 1.0f;
+	float perTick = Dequantize(SNAPSHOT_STAT_SPEC, state.speed) / SNAPSHOT_RECKON_TICK_RATE * 0.01f * boost;
+	return distance + perTick * (tick - state.distanceTick);
+}
+
+namespace EUdpPacket
+{
+	enum Type : unsigned char
+	{
+		Hello,	// 클라 -> 서버. 토큰으로 TCP 연결과 묶음.
+		Data,	// MessageHeader + 바디가 뒤에 붙음.
+		Ack		// 받은 번호만 알려줌.
+	};
+}
+
+// UDP 데이터그램 하나 = UdpPacketHeader + (Data 면) MessageHeader + 바디.
+#pragma pack(push, 1)
+struct UdpPacketHeader
+{
+	unsigned int token;
+	unsigned char packetType;
+	unsigned char delivery;		// EUdpDelivery
+	unsigned short seq;			// 이 패킷 번호. 방향마다 따로 셈. 1 부터 시작하고 0 은 건너뜀.
+	unsigned short ack;			// 상대한테서 받은 가장 최근 번호. 0 이면 아직 받은게 없음.
+	unsigned int ackBits;		// ack 이전 32개 패킷의 수신 여부. 비트 n 이 ack - 1 - n.
+	unsigned short reliableId;	// Reliable 일때 메시지 번호. 재전송돼도 같음.
+};
+#pragma pack(pop)
+
+// 16비트 순서 번호가 한바퀴 돌아도 a 가 b 보다 최신인지.
+inline bool IsSeqNewer(unsigned short a, unsigned short b)
+{
+	return (short)(a - b) > 0;
+}
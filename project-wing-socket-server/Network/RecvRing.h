@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Network/Protocol.h"
+
+// 연결마다 가지는 수신 링버퍼 크기. 2 의 거듭제곱이어야 함.
+#define RECV_RING_SIZE (16 * 1024)
+
+// 클라가 보내는 메시지 바디의 최대 크기. 넘으면 잘못된 헤더로 보고 끊음.
+#define MAX_CLIENT_BODY_LEN 1024
+
+static_assert((RECV_RING_SIZE & (RECV_RING_SIZE - 1)) == 0, "RECV_RING_SIZE must be a power of two");
+static_assert(RECV_RING_SIZE >= sizeof(MessageHeader) + MAX_CLIENT_BODY_LEN, "ring must hold the largest message");
+
+// 고정 크기 수신 링버퍼. 연결이 만들어질때 한번 잡고 이후로는 할당 없음.
+// 소켓에서 읽을때는 빈 공간 두 조각을 WSABUF 로 넘겨서 한번에 최대한 받고,
+// 메시지는 링 안에서 바로 잘라서 바디 포인터만 넘김.
+class CRecvRing
+{
+private:
+	char mBuffer[RECV_RING_SIZE];
+
+	// 링 끝에서 감긴 바디만 여기로 이어붙여서 넘김.
+	char mWrapScratch[MAX_CLIENT_BODY_LEN];
+
+	// 계속 늘어나기만 하는 위치. 실제 인덱스는 RECV_RING_SIZE 로 마스킹.
+	size_t mReadPos = 0;
+	size_t mWritePos = 0;
+
+public:
+	inline size_t GetSize() const { return mWritePos - mReadPos; }
+	inline size_t GetFree() const { return RECV_RING_SIZE - GetSize(); }
+
+	// 빈 공간을 WSABUF 로 돌려줌. 링 끝에서 감기면 두 조각.
+	DWORD GetWriteBuffers(WSABUF* bufs)
+	{
+		size_t freeBytes = GetFree();
+		size_t start = mWritePos & (RECV_RING_SIZE - 1);
+		size_t firstLen = std::min(freeBytes, (size_t)RECV_RING_SIZE - start);
+
+		bufs[0].buf = mBuffer + start;
+		bufs[0].len = (ULONG)firstLen;
+
+		if (firstLen == freeBytes)
+			return 1;
+
+		bufs[1].buf = mBuffer;
+		bufs[1].len = (ULONG)(freeBytes - firstLen);
+		return 2;
+	}
+
+	// 소켓이 채워준 만큼 쓰기 위치를 옮김.
+	inline void Commit(size_t bytes) { mWritePos += bytes; }
+
+	inline void Consume(size_t bytes) { mReadPos += bytes; }
+
+	// 읽기 위치에서 offset 만큼 떨어진 곳부터 len 바이트를 복사함.
+	void Peek(size_t offset, void* dest, size_t len) const
+	{
+		size_t start = (mReadPos + offset) & (RECV_RING_SIZE - 1);
+		size_t firstLen = std::min(len, (size_t)RECV_RING_SIZE - start);
+
+		memcpy(dest, mBuffer + start, firstLen);
+		memcpy((char*)dest + firstLen, mBuffer, len - firstLen);
+	}
+
+	// 읽기 위치에서 offset 만큼 떨어진 곳부터 len 바이트를 연속된 포인터로 돌려줌.
+	// 대부분 링 안을 그대로 가리키고, 감긴 경우만 스크래치로 복사함.
+	// 다음 Consume / Commit 전까지만 유효함.
+	const char* View(size_t offset, size_t len)
+	{
+		size_t start = (mReadPos + offset) & (RECV_RING_SIZE - 1);
+
+		if (start + len <= RECV_RING_SIZE)
+			return mBuffer + start;
+
+		Peek(offset, mWrapScratch, len);
+		return mWrapScratch;
+	}
+};
@@ -0,0 +1,262 @@
+﻿#include "Network/SnapshotCodec.h"
+
+// 줄였다 되살린 값이 범위 안으로 붙인 원래 값에서 반 칸 (+ float 반올림 여유) 안인지.
+static bool IsWithinHalfStep(const FQuantSpec& spec, float original, float decoded)
+{
+	float expected = clamp(original, spec.minValue, spec.maxValue);
+	return fabsf(decoded - expected) <= spec.step * 0.5f * 1.01f;
+}
+
+// WriteVar 가 쓰는 비트 수.
+static int VarBits(unsigned int value)
+{
+	int bytes = 1;
+
+	while (value >= 0x80)
+	{
+		bytes++;
+		value >>= 7;
+	}
+
+	return bytes * 8;
+}
+
+static bool CheckPackedSnapshot(int tick, const std::vector<PlayerSnapshot>& players)
+{
+	std::vector<char> body;
+	WritePackedSnapshot(body, tick, players.data(), (int)players.size());
+
+	// 비트 폭이 형식 설명과 같은지. 끝은 바이트로 맞춰져 있어야 함.
+	int bits = VarBits((unsigned int)tick) + SNAPSHOT_PACKED_COUNT_BITS;
+	for (auto& player : players)
+	{
+		bits += VarBits((unsigned int)player.id) + SNAPSHOT_PACKED_FLAG_BITS
+			+ SNAPSHOT_HEIGHT_SPEC.bits + SNAPSHOT_DISTANCE_SPEC.bits + SNAPSHOT_HP_SPEC.bits;
+	}
+
+	if ((int)body.size() != (bits + 7) / 8)
+		return false;
+
+	int decodedTick = 0;
+	std::vector<PlayerSnapshot> decoded;
+
+	if (!ReadPackedSnapshot(body.data(), (int)body.size(), decodedTick, decoded))
+		return false;
+
+	if (decodedTick != tick || decoded.size() != players.size())
+		return false;
+
+	for (size_t i = 0; i < players.size(); i++)
+	{
+		const PlayerSnapshot& from = players[i];
+		const PlayerSnapshot& to = decoded[i];
+
+		if (from.id != to.id || from.flags != to.flags)
+			return false;
+
+		if (!IsWithinHalfStep(SNAPSHOT_HEIGHT_SPEC, from.height, to.height)
+			|| !IsWithinHalfStep(SNAPSHOT_DISTANCE_SPEC, from.distance, to.distance)
+			|| !IsWithinHalfStep(SNAPSHOT_HP_SPEC, from.hp, to.hp))
+			return false;
+	}
+
+	// 끝 바이트에는 항상 값 비트가 있어서 한 바이트라도 잘리면 읽기가 실패해야 함.
+	for (int len = 0; len < (int)body.size(); len++)
+	{
+		if (ReadPackedSnapshot(body.data(), len, decodedTick, decoded))
+			return false;
+	}
+
+	return true;
+}
+
+static bool CheckPackedSnapshots()
+{
+	const int maxCount = (1 << SNAPSHOT_PACKED_COUNT_BITS) - 1;
+	const unsigned char allFlags = EPlayerSnapshotFlag::Alive | EPlayerSnapshotFlag::Stun
+		| EPlayerSnapshotFlag::Protection | EPlayerSnapshotFlag::Boost | EPlayerSnapshotFlag::MovingUp;
+
+	// 범위 양 끝, 범위 밖, 칸 사이 값. id 는 var 길이가 1 ~ 5바이트가 되게.
+	const PlayerSnapshot edges[] =
+	{
+		{ 0, SNAPSHOT_DISTANCE_SPEC.minValue, SNAPSHOT_HEIGHT_SPEC.minValue, SNAPSHOT_HP_SPEC.minValue, 0 },
+		{ 127, SNAPSHOT_DISTANCE_SPEC.maxValue, SNAPSHOT_HEIGHT_SPEC.maxValue, SNAPSHOT_HP_SPEC.maxValue, allFlags },
+		{ 128, 12345.678f, 0.0f, 99.95f, EPlayerSnapshotFlag::Alive },
+		{ 16384, -5.0f, -1000.0f, -1.0f, EPlayerSnapshotFlag::Boost },
+		{ 0x7FFFFFFF, 1.0e9f, 1000.0f, 5000.0f, EPlayerSnapshotFlag::MovingUp },
+		{ 7, 0.015625f, 0.0625f, 0.05f, EPlayerSnapshotFlag::Stun | EPlayerSnapshotFlag::Protection },
+	};
+
+	std::vector<PlayerSnapshot> players;
+
+	if (!CheckPackedSnapshot(0, players))
+		return false;
+
+	players.assign(std::begin(edges), std::end(edges));
+
+	if (!CheckPackedSnapshot(0x7FFFFFFF, players))
+		return false;
+
+	// 인원 칸이 꽉 찰때.
+	players.clear();
+	for (int i = 0; i < maxCount; i++)
+		players.push_back(edges[i % (sizeof(edges) / sizeof(edges[0]))]);
+
+	return CheckPackedSnapshot(123456, players);
+}
+
+static bool IsSamePackedPlayer(const FPackedPlayerState& a, const FPackedPlayerState& b)
+{
+	return a.id == b.id && a.flags == b.flags && a.height == b.height && a.distance == b.distance
+		&& a.hp == b.hp && a.dex == b.dex && a.speed == b.speed
+		&& a.heightTick == b.heightTick && a.distanceTick == b.distanceTick;
+}
+
+// 기준 + 델타로 복원한 상태가 보낸 상태와 칸 번호, 기준점 틱까지 똑같은지.
+static bool CheckDeltaSnapshot(const FDeltaSnapshotInfo& info, const std::vector<FPackedPlayerState>& players,
+	const std::vector<FPackedPlayerState>* baseline)
+{
+	// 빈 기준도 찾은 기준이라 nullptr 이 아닌 칸을 넘김.
+	FPackedPlayerState baselineStore[(1 << SNAPSHOT_PACKED_COUNT_BITS) - 1];
+	int baselineCount = baseline ? (int)baseline->size() : 0;
+	std::copy_n(baseline ? baseline->data() : baselineStore, baselineCount, baselineStore);
+	const FPackedPlayerState* baselinePlayers = baseline ? baselineStore : nullptr;
+
+	std::vector<char> body;
+	WriteDeltaSnapshot(body, info, players.data(), (int)players.size(), baselinePlayers, baselineCount);
+
+	unsigned int baselineSeq = 0;
+	if (!PeekDeltaBaselineSeq(body.data(), (int)body.size(), baselineSeq) || baselineSeq != info.baselineSeq)
+		return false;
+
+	const int maxCount = (1 << SNAPSHOT_PACKED_COUNT_BITS) - 1;
+	FPackedPlayerState decoded[maxCount];
+	FDeltaSnapshotInfo decodedInfo;
+	int decodedCount = 0;
+
+	if (!ReadDeltaSnapshot(body.data(), (int)body.size(), baselinePlayers, baselineCount, decodedInfo, decoded, maxCount, decodedCount))
+		return false;
+
+	if (decodedInfo.seq != info.seq || decodedInfo.baselineSeq != info.baselineSeq
+		|| decodedInfo.tick != info.tick || decodedInfo.isReckoning != info.isReckoning
+		|| decodedCount != (int)players.size())
+		return false;
+
+	for (int i = 0; i < decodedCount; i++)
+	{
+		if (!IsSamePackedPlayer(decoded[i], players[i]))
+			return false;
+	}
+
+	for (int len = 0; len < (int)body.size(); len++)
+	{
+		if (ReadDeltaSnapshot(body.data(), len, baselinePlayers, baselineCount, decodedInfo, decoded, maxCount, decodedCount))
+			return false;
+	}
+
+	// 기준 번호가 있는데 기준을 못 찾은 받는 쪽은 복원하면 안 됨.
+	if (baseline && ReadDeltaSnapshot(body.data(), (int)body.size(), nullptr, 0, decodedInfo, decoded, maxCount, decodedCount))
+		return false;
+
+	return true;
+}
+
+static FPackedPlayerState MakePackedPlayer(int id, unsigned int flags, unsigned int height, unsigned int distance,
+	unsigned int hp, int tick)
+{
+	FPackedPlayerState state;
+	state.id = id;
+	state.flags = flags;
+	state.height = height;
+	state.distance = distance;
+	state.hp = hp;
+	state.dex = Quantize(SNAPSHOT_STAT_SPEC, 100.0f);
+	state.speed = Quantize(SNAPSHOT_STAT_SPEC, 700.0f);
+	state.heightTick = tick;
+	state.distanceTick = tick;
+	return state;
+}
+
+static bool CheckDeltaSnapshots()
+{
+	const unsigned int moving = EPlayerSnapshotFlag::Alive | EPlayerSnapshotFlag::MovingUp;
+	const int baseTick = 1000;
+	const int tick = baseTick + 6;
+
+	std::vector<FPackedPlayerState> baseline =
+	{
+		MakePackedPlayer(1, moving, 0, 0, 0, baseTick),
+		MakePackedPlayer(2, EPlayerSnapshotFlag::Alive, SNAPSHOT_HEIGHT_SPEC.maxCode, SNAPSHOT_DISTANCE_SPEC.maxCode, SNAPSHOT_HP_SPEC.maxCode, baseTick),
+		MakePackedPlayer(300, moving | EPlayerSnapshotFlag::Boost, 2880, 32000, 1000, baseTick - 40),
+		MakePackedPlayer(0x7FFFFFFF, EPlayerSnapshotFlag::Stun, 100, 1, 1, baseTick),
+	};
+
+	for (int isReckoning = 0; isReckoning < 2; isReckoning++)
+	{
+		FDeltaSnapshotInfo info;
+		info.seq = 0x12345;
+		info.tick = tick;
+		info.isReckoning = isReckoning != 0;
+
+		// 레커닝이 아니면 서버는 높이/거리 기준점을 항상 지금 틱으로 찍음.
+		auto stamp = [&info](std::vector<FPackedPlayerState> players)
+		{
+			for (auto& player : players)
+			{
+				if (!info.isReckoning)
+				{
+					player.heightTick = info.tick;
+					player.distanceTick = info.tick;
+				}
+			}
+
+			return players;
+		};
+
+		// 기준 없이 전부.
+		info.baselineSeq = 0;
+		if (!CheckDeltaSnapshot(info, stamp(baseline), nullptr))
+			return false;
+
+		std::vector<FPackedPlayerState> from = stamp(baseline);
+		info.baselineSeq = 77;
+
+		// 같은 명단. 안 바뀐 플레이어, 필드 하나씩 바뀐 플레이어, 전부 바뀐 플레이어.
+		std::vector<FPackedPlayerState> players = from;
+		players[1].flags = 0;
+		players[1].hp = 0;
+		players[2].height = SNAPSHOT_HEIGHT_SPEC.maxCode;
+		players[2].heightTick = info.isReckoning ? tick - 3 : tick;
+		players[3] = MakePackedPlayer(players[3].id, moving, 5, SNAPSHOT_DISTANCE_SPEC.maxCode, 7, tick);
+		players[3].dex = SNAPSHOT_STAT_SPEC.maxCode;
+		players[3].speed = 0;
+
+		if (!CheckDeltaSnapshot(info, players, &from))
+			return false;
+
+		// 명단이 바뀜. 나간 플레이어, 새 플레이어, 순서 바뀜.
+		players = { from[2], MakePackedPlayer(128, moving, 1, 2, 3, tick), from[0] };
+		players[2].distance = 99;
+		players[2].distanceTick = info.isReckoning ? tick - 5 : tick;
+
+		if (!CheckDeltaSnapshot(info, players, &from))
+			return false;
+
+		// 다 나감.
+		players.clear();
+		if (!CheckDeltaSnapshot(info, players, &from))
+			return false;
+
+		// 빈 기준에서 빈 스냅샷.
+		std::vector<FPackedPlayerState> empty;
+		if (!CheckDeltaSnapshot(info, players, &empty))
+			return false;
+	}
+
+	return true;
+}
+
+bool CheckSnapshotCodec()
+{
+	return CheckPackedSnapshots() && CheckDeltaSnapshots();
+}
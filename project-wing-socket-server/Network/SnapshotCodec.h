@@ -0,0 +1,227 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Network/BitPacker.h"
+#include "Network/Protocol.h"
+
+// 비트로 줄인 스냅샷 바디 쓰기/읽기. 형식은 Protocol.h 의 MSG_WORLD_SNAPSHOT_PACKED, _DELTA 설명.
+// 서버는 쓰기만 하지만 읽기도 같은 곳에 둬서 형식이 한쪽만 바뀌지 않게 함.
+
+// MSG_WORLD_SNAPSHOT_PACKED 바디를 out 뒤에 씀.
+inline void WritePackedSnapshot(std::vector<char>& out, int tick, const PlayerSnapshot* players, int count)
+{
+	CBitWriter writer(out);
+
+	writer.WriteVar((unsigned int)tick);
+	writer.Write((unsigned int)count, SNAPSHOT_PACKED_COUNT_BITS);
+
+	for (int i = 0; i < count; i++)
+	{
+		const PlayerSnapshot& player = players[i];
+		writer.WriteVar((unsigned int)player.id);
+		writer.Write(player.flags, SNAPSHOT_PACKED_FLAG_BITS);
+		writer.WriteQuant(SNAPSHOT_HEIGHT_SPEC, player.height);
+		writer.WriteQuant(SNAPSHOT_DISTANCE_SPEC, player.distance);
+		writer.WriteQuant(SNAPSHOT_HP_SPEC, player.hp);
+	}
+
+	writer.Flush();
+}
+
+// 바디가 모자라거나 칸 번호가 범위 밖이면 false.
+inline bool ReadPackedSnapshot(const char* body, int len, int& outTick, std::vector<PlayerSnapshot>& outPlayers)
+{
+	CBitReader reader(body, len);
+
+	outTick = (int)reader.ReadVar();
+	int count = (int)reader.Read(SNAPSHOT_PACKED_COUNT_BITS);
+
+	outPlayers.clear();
+
+	for (int i = 0; i < count && !reader.IsFailed(); i++)
+	{
+		PlayerSnapshot player;
+		player.id = (int)reader.ReadVar();
+		player.flags = (unsigned char)reader.Read(SNAPSHOT_PACKED_FLAG_BITS);
+		player.height = reader.ReadQuant(SNAPSHOT_HEIGHT_SPEC);
+		player.distance = reader.ReadQuant(SNAPSHOT_DISTANCE_SPEC);
+		player.hp = reader.ReadQuant(SNAPSHOT_HP_SPEC);
+		outPlayers.push_back(player);
+	}
+
+	// 남는건 Flush 로 채운 8비트 미만뿐이어야 함.
+	return !reader.IsFailed() && reader.GetRemainBits() < 8;
+}
+
+// MSG_WORLD_SNAPSHOT_DELTA 앞부분.
+struct FDeltaSnapshotInfo
+{
+	unsigned int seq = 0;
+	unsigned int baselineSeq = 0;	// 0 이면 기준 없이 전부.
+	int tick = 0;
+	bool isReckoning = false;
+};
+
+// 없으면 nullptr.
+inline const FPackedPlayerState* FindPackedPlayer(const FPackedPlayerState* players, int count, int id)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (players[i].id == id)
+			return &players[i];
+	}
+
+	return nullptr;
+}
+
+// MSG_WORLD_SNAPSHOT_DELTA 바디를 out 뒤에 씀. baseline 이 nullptr 이면 info.baselineSeq 는 0 이어야 함.
+// 빈 기준도 찾은 기준이라 nullptr 이 아닌 칸으로 넘김.
+inline void WriteDeltaSnapshot(std::vector<char>& out, const FDeltaSnapshotInfo& info,
+	const FPackedPlayerState* players, int count, const FPackedPlayerState* baseline, int baselineCount)
+{
+	bool isSameRoster = baseline && baselineCount == count;
+	for (int i = 0; isSameRoster && i < count; i++)
+		isSameRoster = baseline[i].id == players[i].id;
+
+	CBitWriter writer(out);
+
+	writer.WriteVar(info.seq);
+	writer.WriteVar(info.baselineSeq);
+	writer.WriteVar((unsigned int)info.tick);
+	writer.WriteBool(info.isReckoning);
+	writer.WriteBool(isSameRoster);
+
+	if (!isSameRoster)
+	{
+		writer.Write((unsigned int)count, SNAPSHOT_PACKED_COUNT_BITS);
+
+		for (int i = 0; i < count; i++)
+			writer.WriteVar((unsigned int)players[i].id);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		const FPackedPlayerState& player = players[i];
+		int mask = ESnapshotField::All;
+
+		// 순서가 같으면 같은 칸, 아니면 id 로 찾음. 기준에 없던 플레이어면 전부.
+		if (baseline)
+		{
+			const FPackedPlayerState* from = isSameRoster ? &baseline[i] : FindPackedPlayer(baseline, baselineCount, player.id);
+
+			if (from)
+				mask = DiffPackedPlayer(*from, player);
+		}
+
+		writer.Write((unsigned int)mask, SNAPSHOT_DELTA_FIELD_BITS);
+
+		if (mask & ESnapshotField::Flags) writer.Write(player.flags, SNAPSHOT_PACKED_FLAG_BITS);
+
+		if (mask & ESnapshotField::Height)
+		{
+			writer.Write(player.height, SNAPSHOT_HEIGHT_SPEC.bits);
+			if (info.isReckoning)
+				writer.WriteVar((unsigned int)(info.tick - player.heightTick));
+		}
+
+		if (mask & ESnapshotField::Distance)
+		{
+			writer.Write(player.distance, SNAPSHOT_DISTANCE_SPEC.bits);
+			if (info.isReckoning)
+				writer.WriteVar((unsigned int)(info.tick - player.distanceTick));
+		}
+
+		if (mask & ESnapshotField::Hp) writer.Write(player.hp, SNAPSHOT_HP_SPEC.bits);
+
+		if (mask & ESnapshotField::Stats)
+		{
+			writer.Write(player.dex, SNAPSHOT_STAT_SPEC.bits);
+			writer.Write(player.speed, SNAPSHOT_STAT_SPEC.bits);
+		}
+	}
+
+	writer.Flush();
+}
+
+// 바디 맨 앞의 기준 번호. 받는 쪽은 이걸로 기억해둔 스냅샷을 찾아서 ReadDeltaSnapshot 에 넘김.
+inline bool PeekDeltaBaselineSeq(const char* body, int len, unsigned int& outBaselineSeq)
+{
+	CBitReader reader(body, len);
+	reader.ReadVar();
+	outBaselineSeq = reader.ReadVar();
+	return !reader.IsFailed();
+}
+
+// 기준 스냅샷에 바뀐 필드만 덮어써서 다 채운 상태를 outPlayers 에 만듦. 기준을 못 찾았으면 baseline 은 nullptr.
+// 기준 번호가 있는데 baseline 을 못 주거나, 바디가 모자라거나, maxPlayers 를 넘으면 false.
+inline bool ReadDeltaSnapshot(const char* body, int len, const FPackedPlayerState* baseline, int baselineCount,
+	FDeltaSnapshotInfo& outInfo, FPackedPlayerState* outPlayers, int maxPlayers, int& outCount)
+{
+	CBitReader reader(body, len);
+
+	outInfo.seq = reader.ReadVar();
+	outInfo.baselineSeq = reader.ReadVar();
+	outInfo.tick = (int)reader.ReadVar();
+	outInfo.isReckoning = reader.ReadBool();
+	bool isSameRoster = reader.ReadBool();
+
+	if (outInfo.baselineSeq == 0)
+	{
+		baseline = nullptr;
+		baselineCount = 0;
+	}
+	else if (!baseline)
+		return false;
+
+	if (isSameRoster && !baseline)
+		return false;
+
+	int count = isSameRoster ? baselineCount : (int)reader.Read(SNAPSHOT_PACKED_COUNT_BITS);
+	if (reader.IsFailed() || count > maxPlayers)
+		return false;
+
+	for (int i = 0; i < count; i++)
+		outPlayers[i].id = isSameRoster ? baseline[i].id : (int)reader.ReadVar();
+
+	for (int i = 0; i < count && !reader.IsFailed(); i++)
+	{
+		FPackedPlayerState& player = outPlayers[i];
+		const FPackedPlayerState* from = isSameRoster ? &baseline[i] : FindPackedPlayer(baseline, baselineCount, player.id);
+		int mask = (int)reader.Read(SNAPSHOT_DELTA_FIELD_BITS);
+
+		// 기준에 없던 플레이어는 전부 와야 함.
+		if (from)
+			player = *from;
+		else if (mask != ESnapshotField::All)
+			return false;
+
+		if (mask & ESnapshotField::Flags) player.flags = reader.Read(SNAPSHOT_PACKED_FLAG_BITS);
+
+		if (mask & ESnapshotField::Height)
+		{
+			player.height = reader.ReadCode(SNAPSHOT_HEIGHT_SPEC);
+			player.heightTick = outInfo.isReckoning ? outInfo.tick - (int)reader.ReadVar() : outInfo.tick;
+		}
+
+		if (mask & ESnapshotField::Distance)
+		{
+			player.distance = reader.ReadCode(SNAPSHOT_DISTANCE_SPEC);
+			player.distanceTick = outInfo.isReckoning ? outInfo.tick - (int)reader.ReadVar() : outInfo.tick;
+		}
+
+		if (mask & ESnapshotField::Hp) player.hp = reader.ReadCode(SNAPSHOT_HP_SPEC);
+
+		if (mask & ESnapshotField::Stats)
+		{
+			player.dex = reader.ReadCode(SNAPSHOT_STAT_SPEC);
+			player.speed = reader.ReadCode(SNAPSHOT_STAT_SPEC);
+		}
+	}
+
+	outCount = count;
+	return !reader.IsFailed() && reader.GetRemainBits() < 8;
+}
+
+// 위 쓰기/읽기를 범위 끝 값과 잘린 바디로 돌려보고 어긋나면 false.
+// 서버 시작할때 한번 부름. SnapshotCodec.cpp.
+bool CheckSnapshotCodec();
@@ -0,0 +1,341 @@
+﻿#include "Network/UdpChannel.h"
+
+DEFINITION_SINGLE(CUdpChannel);
+
+CUdpChannel::CUdpChannel()
+{
+
+}
+
+CUdpChannel::~CUdpChannel()
+{
+
+}
+
+bool CUdpChannel::Init(INetworkBackend* tcp, unsigned short port, MessageCallback onMessage)
+{
+	mTcp = tcp;
+	mOnMessage = std::move(onMessage);
+	mTokenRandom.seed(std::random_device{}());
+
+	SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock == INVALID_SOCKET)
+		return false;
+
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = INADDR_ANY;
+	addr.sin_port = htons(port);
+
+	if (bind(sock, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR)
+	{
+		closesocket(sock);
+		return false;
+	}
+
+	u_long nonBlocking = 1;
+	ioctlsocket(sock, FIONBIO, &nonBlocking);
+
+	mSock = sock;
+	mPort = port;
+
+	std::thread(&CUdpChannel::ThreadLoop, this).detach();
+
+	std::cout << "[UDP] channel on port " << port << "\n";
+	return true;
+}
+
+unsigned int CUdpChannel::CreateSession(Connection* conn)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	unsigned int token = 0;
+	while (token == 0 || mSessionsByToken.count(token) > 0)
+		token = mTokenRandom();
+
+	FUdpSession* session = new FUdpSession;
+	session->conn = conn;
+	session->token = token;
+
+	// 0 번은 "아직 받은게 없음" 으로 쓰니 1 부터.
+	session->nextSeq = 1;
+
+	mSessionsByToken[token] = session;
+	mSessionsByConn[conn] = session;
+	return token;
+}
+
+void CUdpChannel::RemoveSession(Connection* conn)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto iter = mSessionsByConn.find(conn);
+	if (iter == mSessionsByConn.end())
+		return;
+
+	FUdpSession* session = iter->second;
+	mSessionsByConn.erase(iter);
+	mSessionsByToken.erase(session->token);
+	delete session;
+}
+
+bool CUdpChannel::Send(Connection* conn, const FramePtr& frame)
+{
+	EUdpDelivery::Type delivery = GetUdpDelivery(frame->msgType);
+
+	if (delivery == EUdpDelivery::None)
+		return false;
+
+	if (sizeof(UdpPacketHeader) + frame->GetSize() > UDP_MAX_PACKET_SIZE)
+		return false;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto iter = mSessionsByConn.find(conn);
+	if (iter == mSessionsByConn.end() || !iter->second->isBound)
+		return false;
+
+	FUdpSession* session = iter->second;
+
+	// 못 가도 다음 스냅샷이 곧 감.
+	if (delivery == EUdpDelivery::Unreliable)
+	{
+		SendPacket(session, delivery, 0, frame);
+		return true;
+	}
+
+	FPendingReliable pending;
+	pending.reliableId = session->nextReliableId++;
+	pending.frame = frame;
+	pending.lastSendTime = GetTickCount64();
+	pending.lastSeq = SendPacket(session, delivery, pending.reliableId, frame);
+	session->pendingReliables.push_back(pending);
+	return true;
+}
+
+// mMutex 잡은 상태로 호출. 보낸 패킷 번호를 돌려줌.
+unsigned short CUdpChannel::SendPacket(FUdpSession* session, EUdpDelivery::Type delivery, unsigned short reliableId, const FramePtr& frame)
+{
+	char buffer[UDP_MAX_PACKET_SIZE];
+
+	UdpPacketHeader packet{};
+	packet.token = session->token;
+	packet.packetType = EUdpPacket::Data;
+	packet.delivery = delivery;
+	packet.seq = session->nextSeq;
+	packet.ack = session->hasRemoteSeq ? session->remoteSeq : 0;
+	packet.ackBits = session->remoteAckBits;
+	packet.reliableId = reliableId;
+
+	if (++session->nextSeq == 0)
+		session->nextSeq = 1;
+
+	memcpy(buffer, &packet, sizeof(packet));
+	memcpy(buffer + sizeof(packet), frame->GetData(), frame->GetSize());
+
+	// UDP 는 송신 버퍼가 차도 막히지 않고 버려짐. 신뢰 메시지는 재전송이 처리함.
+	sendto(mSock, buffer, (int)(sizeof(packet) + frame->GetSize()), 0
+		, (sockaddr*)&session->addr, sizeof(session->addr));
+
+	return packet.seq;
+}
+
+void CUdpChannel::ThreadLoop()
+{
+	while (true)
+	{
+		WSAPOLLFD pollFd{ mSock, POLLRDNORM, 0 };
+
+		if (WSAPoll(&pollFd, 1, UDP_TICK_MS) > 0)
+			ReceivePackets();
+
+		ResendExpired();
+
+		// Hello 응답이나 TCP 로 돌린 메시지를 내보냄.
+		mTcp->Flush();
+	}
+}
+
+void CUdpChannel::ReceivePackets()
+{
+	char buffer[UDP_MAX_PACKET_SIZE];
+
+	while (true)
+	{
+		sockaddr_in from{};
+		int fromLen = sizeof(from);
+		int r = recvfrom(mSock, buffer, sizeof(buffer), 0, (sockaddr*)&from, &fromLen);
+
+		if (r == SOCKET_ERROR)
+		{
+			// 예전에 보낸 주소가 닫혔다는 ICMP 라서 무시하고 계속 읽음.
+			if (WSAGetLastError() == WSAECONNRESET)
+				continue;
+
+			break;
+		}
+
+		if (r < (int)sizeof(UdpPacketHeader))
+			continue;
+
+		UdpPacketHeader packet;
+		memcpy(&packet, buffer, sizeof(packet));
+
+		MessageHeader header{};
+		const char* body = nullptr;
+
+		if (packet.packetType == EUdpPacket::Data)
+		{
+			size_t remain = r - sizeof(packet);
+			if (remain < sizeof(header))
+				continue;
+
+			memcpy(&header, buffer + sizeof(packet), sizeof(header));
+			if (header.bodyLen < 0 || (size_t)header.bodyLen > remain - sizeof(header))
+				continue;
+
+			body = buffer + sizeof(packet) + sizeof(header);
+		}
+
+		Connection* inputConn = nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			auto iter = mSessionsByToken.find(packet.token);
+			if (iter == mSessionsByToken.end())
+				continue;
+
+			FUdpSession* session = iter->second;
+
+			// 모바일은 주소가 바뀔 수 있어서 토큰이 맞으면 마지막 주소로 계속 갱신함.
+			bool isNewBinding = !session->isBound;
+			session->addr = from;
+			session->isBound = true;
+
+			if (isNewBinding)
+				mTcp->Enqueue(session->conn, MakeFrame(0, (int)ServerMessage::MSG_UDP_READY, nullptr, 0));
+
+			if (packet.packetType == EUdpPacket::Hello)
+				continue;
+
+			RecordRemoteSeq(session, packet.seq);
+			OnPacketAcked(session, packet);
+
+			// 입력은 최신 값만 의미 있어서 늦게 온 패킷은 버림.
+			if (packet.packetType == EUdpPacket::Data && IsUdpClientMessage(header.msgType)
+				&& (!session->hasInputSeq || IsSeqNewer(packet.seq, session->lastInputSeq)))
+			{
+				session->hasInputSeq = true;
+				session->lastInputSeq = packet.seq;
+
+				// 락을 놓은 뒤에 세션이 지워져도 연결은 남아 있게 잡아둠.
+				inputConn = session->conn;
+				inputConn->AddRef();
+			}
+		}
+
+		if (inputConn)
+		{
+			mOnMessage(inputConn, header, body);
+			inputConn->Release();
+		}
+	}
+}
+
+// mMutex 잡은 상태로 호출.
+void CUdpChannel::RecordRemoteSeq(FUdpSession* session, unsigned short seq)
+{
+	if (!session->hasRemoteSeq)
+	{
+		session->hasRemoteSeq = true;
+		session->remoteSeq = seq;
+		session->remoteAckBits = 0;
+		return;
+	}
+
+	if (IsSeqNewer(seq, session->remoteSeq))
+	{
+		// 이전 최신 번호도 받은 목록으로 밀어넣음.
+		unsigned short shift = seq - session->remoteSeq;
+
+		if (shift < 32)
+			session->remoteAckBits = (session->remoteAckBits << shift) | (1u << (shift - 1));
+		else
+			session->remoteAckBits = (shift == 32) ? (1u << 31) : 0;
+
+		session->remoteSeq = seq;
+		return;
+	}
+
+	unsigned short diff = session->remoteSeq - seq;
+	if (diff >= 1 && diff <= 32)
+		session->remoteAckBits |= 1u << (diff - 1);
+}
+
+// mMutex 잡은 상태로 호출.
+void CUdpChannel::OnPacketAcked(FUdpSession* session, const UdpPacketHeader& packet)
+{
+	// 0 이면 클라가 아직 아무것도 못 받은 것.
+	if (packet.ack == 0)
+		return;
+
+	auto& pendings = session->pendingReliables;
+
+	for (auto iter = pendings.begin(); iter != pendings.end();)
+	{
+		unsigned short diff = packet.ack - iter->lastSeq;
+		bool isAcked = (diff == 0)
+			|| (diff <= 32 && (packet.ackBits & (1u << (diff - 1))));
+
+		if (isAcked)
+			iter = pendings.erase(iter);
+		else
+			++iter;
+	}
+}
+
+void CUdpChannel::ResendExpired()
+{
+	ULONGLONG now = GetTickCount64();
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	for (auto& pair : mSessionsByToken)
+	{
+		FUdpSession* session = pair.second;
+
+		if (!session->isBound)
+			continue;
+
+		for (auto& pending : session->pendingReliables)
+		{
+			if (now - pending.lastSendTime < UDP_RESEND_INTERVAL_MS)
+				continue;
+
+			if (pending.resendCount >= UDP_MAX_RESEND_COUNT)
+			{
+				FallbackToTcp(session);
+				break;
+			}
+
+			pending.resendCount++;
+			pending.lastSendTime = now;
+			pending.lastSeq = SendPacket(session, EUdpDelivery::Reliable, pending.reliableId, pending.frame);
+		}
+	}
+}
+
+// mMutex 잡은 상태로 호출.
+// 세션을 풀고 ack 못 받은 메시지는 순서대로 TCP 로 넘김. 클라가 다시 Hello 하면 재개.
+// 연결 정리는 RemoveSession 이 끝난 뒤라 세션이 있는 동안 conn 은 살아있음.
+void CUdpChannel::FallbackToTcp(FUdpSession* session)
+{
+	std::cout << "[UDP] no ack from token " << session->token << ". fallback to TCP.\n";
+
+	session->isBound = false;
+
+	for (auto& pending : session->pendingReliables)
+		mTcp->Enqueue(session->conn, pending.frame);
+
+	session->pendingReliables.clear();
+}
@@ -0,0 +1,102 @@
+﻿#pragma once
+
+#include "GameInfo.h"
+#include "Interface/INetworkBackend.h"
+
+// UDP 데이터그램 최대 크기. 이보다 큰 프레임은 TCP 로 보냄.
+#define UDP_MAX_PACKET_SIZE 1200
+
+// ack 없이 이 시간이 지나면 신뢰 메시지를 다시 보냄.
+#define UDP_RESEND_INTERVAL_MS 100
+
+// 이만큼 재전송해도 ack 가 없으면 UDP 경로가 죽은걸로 보고 TCP 로 돌림.
+#define UDP_MAX_RESEND_COUNT 20
+
+// 재전송 검사 주기. 수신이 없어도 이 간격으로 깨어남.
+#define UDP_TICK_MS 10
+
+// TCP 로 접속한 뒤 원하는 클라만 붙는 보조 UDP 채널.
+// 게임중 스냅샷과 이동 입력은 순서 번호만 붙여서 보내고 (오래된건 버림),
+// 사망/스턴/장애물 같은 이벤트는 ack 받을때까지 재전송함.
+// 로비와 제어 메시지는 그대로 TCP.
+class CUdpChannel
+{
+public:
+	using MessageCallback = std::function<void(Connection*, const MessageHeader&, const char*)>;
+
+private:
+	struct FPendingReliable
+	{
+		unsigned short reliableId = 0;
+		unsigned short lastSeq = 0;
+		ULONGLONG lastSendTime = 0;
+		int resendCount = 0;
+		FramePtr frame;
+	};
+
+	struct FUdpSession
+	{
+		Connection* conn = nullptr;
+		unsigned int token = 0;
+
+		// Hello 를 받아야 주소가 정해지고 그때부터 UDP 로 보냄.
+		bool isBound = false;
+		sockaddr_in addr{};
+
+		unsigned short nextSeq = 0;
+		unsigned short nextReliableId = 0;
+
+		// 클라한테서 받은 패킷 번호. 보낼때 ack 로 붙임.
+		bool hasRemoteSeq = false;
+		unsigned short remoteSeq = 0;
+		unsigned int remoteAckBits = 0;
+
+		// 입력은 이것보다 최신 패킷만 받음.
+		bool hasInputSeq = false;
+		unsigned short lastInputSeq = 0;
+
+		// 보낸 순서대로. ack 오면 빠짐.
+		std::deque<FPendingReliable> pendingReliables;
+	};
+
+	SOCKET mSock = INVALID_SOCKET;
+	unsigned short mPort = 0;
+	INetworkBackend* mTcp = nullptr;
+	MessageCallback mOnMessage;
+
+	// 세션 맵과 세션 내용은 이걸로 보호함.
+	// mMutex -> ioMutex 순서로만 잡음. 콜백은 mMutex 를 놓고 부름.
+	std::mutex mMutex;
+	std::unordered_map<unsigned int, FUdpSession*> mSessionsByToken;
+	std::unordered_map<Connection*, FUdpSession*> mSessionsByConn;
+	std::mt19937 mTokenRandom;
+
+public:
+	// tcp 는 UDP 를 포기할때 메시지를 되돌릴 곳.
+	bool Init(INetworkBackend* tcp, unsigned short port, MessageCallback onMessage);
+
+	inline bool IsEnabled() const { return mSock != INVALID_SOCKET; }
+	inline unsigned short GetPort() const { return mPort; }
+
+	// 연결마다 토큰을 만들어 둠. 클라가 이 토큰으로 Hello 를 보내야 묶임.
+	unsigned int CreateSession(Connection* conn);
+
+	// 연결이 정리되기 전에 게임 쪽에서 부름.
+	void RemoveSession(Connection* conn);
+
+	// UDP 로 보낼 종류이고 세션이 묶여 있으면 보내고 true.
+	// false 면 호출자가 TCP 로 보냄.
+	bool Send(Connection* conn, const FramePtr& frame);
+
+private:
+	void ThreadLoop();
+	void ReceivePackets();
+	void ResendExpired();
+
+	void OnPacketAcked(FUdpSession* session, const UdpPacketHeader& packet);
+	void RecordRemoteSeq(FUdpSession* session, unsigned short seq);
+	unsigned short SendPacket(FUdpSession* session, EUdpDelivery::Type delivery, unsigned short reliableId, const FramePtr& frame);
+	void FallbackToTcp(FUdpSession* session);
+
+	DECLARE_SINGLE(CUdpChannel);
+};
@@ -4,171 +4,34 @@
 #include "Etc/CURL.h"
 #include "Etc/DataStorageManager.h"
 #include "Etc/JsonController.h"
-#include "Interface/IPlayerStatController.h"
+#include "Game/Client.h"
+#include "Game/ShardManager.h"
+#include "Game/CollisionManager.h"
+#include "Network/Protocol.h"
+#include "Network/SnapshotCodec.h"
+#include "Network/NetworkReactor.h"
+#include "Network/IocpNetworkBackend.h"
+#include "Network/UdpChannel.h"
+#include "Network/MessageSender.h"
 
 #define PORT 12345
-#define MAX_PLAYERS 5
-#define SCREEN_WIDTH 1280.0f
-#define SCREEN_HEIGHT 720.0f
+#define IO_THREAD_COUNT 2
+#define STATS_REPORT_INTERVAL_MS 10000
+
+// 프로세스 전체 동시 접속 제한. 방이 다 차면 로비에서 기다림.
+#define MAX_CONNECTIONS (MAX_ROOMS * MAX_PLAYERS)
 
 //std::cout << "client_" << c->id
 				//	<< "  " <<
 				//	<< "\n";
 
-// 높이 가운데서부터 시작 함.
-#define PLAYER_INIT_POS_HEIGHT 0.0f
-
-enum GameState { WAITING, RUNNING };
-
-namespace ClientMessage
-{
-	enum Type
-	{
-		MSG_HEARTBEAT,
-		MSG_START,
-		MSG_PICK_CHARACTER,
-		MSG_PICK_ITEM,
-		MSG_PICK_MAP,
-		MSG_READY,
-		MSG_UNREADY,
-		MSG_MOVE_UP,
-		MSG_MOVE_DOWN,
-		MSG_TAKE_DAMAGE, // 맵에 박았을때의 트리거
-		MSG_BOOST_ON,
-		MSG_BOOST_OFF
-	};
-}
-
-namespace ServerMessage
-{
-	enum Type
-	{
-		MSG_CONNECTED,
-		MSG_ROOM_FULL_INFO,
-		MSG_DISCONNECT, // 이건 누가 나간거.
-		MSG_CONNECTED_REJECT,
-		MSG_NEW_OWNER,
-		MSG_JOIN,
-
-		MSG_PICK_MAP,
-		MSG_PICK_ITEM,
-		MSG_PICK_CHARACTER,
-		MSG_READY,
-		MSG_UNREADY,
-		MSG_START_ACK,
-
-		MSG_COUNTDOWN_FINISHED,
-		MSG_PLAYER_DEAD,
-		MSG_GAME_OVER,
-		MSG_MOVE_UP,
-		MSG_MOVE_DOWN,
-		MSG_PLAYER_DISTANCE, // 거리 전송 메시지.
-		MSG_PLAYER_HEIGHT,
-		MSG_TAKEN_DAMAGE,	// 현재 HP 알려줌.
-		MSG_TAKEN_STUN,
-		MSG_BOOST_ON,
-		MSG_BOOST_OFF,
-		MSG_OBSTACLE,
-
-		MSG_HEARTBEAT_ACK,
-		MSG_END
-	};
-}
-
-#pragma pack(push, 1)
-struct MessageHeader
-{
-	int senderId;
-	int msgType;
-	int bodyLen;
-};
-#pragma pack(pop)
-
-struct Obstacle
-{
-	float scale;
-	float rotation;
-	float height;
-};
-
-struct Client : public IPlayerStatController
-{
-	SOCKET sock;
-	int id;
-	std::thread thread;
-
-	bool isReady = false;
-	bool isAlive = true;
-	bool isMovingUp = false;
-
-	int characterId = 0;
-	int itemSlots[3] = { -1, -1, -1 };
-
-	float height = 0.0f;
-
-	int lastObstacleStep = 0;  // 16m 단위로 체크됨
-
-	void Init()
-	{
-		isReady = false;
-		isAlive = true;
-		isMovingUp = false;
-		characterId = 0;
-		itemSlots[0] = -1;
-		itemSlots[1] = -1;
-		itemSlots[2] = -1;
-		height = 0.0f;
-		lastObstacleStep = 0;
-
-		std::cout << "client_" << id
-			<< " Init(): " << "\n";
-	}
-};
-
-std::recursive_mutex gMutex;
-std::vector<Client*> gClients;
-std::unordered_set<int> gDeadPlayers;
-std::map<int, Obstacle> gObstaclesByStep;
-
-GameState gState = WAITING;
-int gNextId = 1;
-int gRoomOwner = -1;
-int gMapId = 0;
+// 방에 있든 로비에 있든 접속중인 클라 수. 접속 제한에만 씀.
+std::atomic<int> gClientCount{ 0 };
+std::atomic<int> gNextId{ 1 };
 
-LARGE_INTEGER mSecond = {}, mTime = {};
-float mDeltaTime = 0.f, mFPS = 0.f, mFPSTime = 0.f;
-int mFPSTick = 0;
-
-void InitTimer()
-{
-	QueryPerformanceFrequency(&mSecond);
-	QueryPerformanceCounter(&mTime);
-}
-
-float UpdateTimer()
-{
-	LARGE_INTEGER Time;
-	QueryPerformanceCounter(&Time);
-	mDeltaTime = (Time.QuadPart - mTime.QuadPart) / (float)mSecond.QuadPart;
-	mTime = Time;
-	mFPSTime += mDeltaTime;
-	++mFPSTick;
-
-	if (mFPSTick == 60)
-	{
-		mFPS = mFPSTick / mFPSTime;
-		mFPSTick = 0;
-		mFPSTime = 0.f;
-	}
-
-	return mDeltaTime;
-}
-
-float GetDeltaTimeFromTimer()
-{
-	return mDeltaTime;
-}
+INetworkBackend* gNetwork = nullptr;
 
+// 접속 거절처럼 백엔드에 등록하지 않은 소켓에 바로 보낼때만 씀.
 bool sendAll(SOCKET sock, const char* data, int len)
 {
 	int sent = 0;
@@ -185,476 +48,299 @@ bool sendAll(SOCKET sock, const char* data, int len)
 	return true;
 }
 
-bool sendMessage(SOCKET sock, int senderId, int msgType, const void* body, int bodyLen)
+// 느린 클라 정책이 걸린 횟수를 찍음. 바뀐게 없으면 생략.
+void ReportBackpressureStats()
 {
-	MessageHeader header{ senderId, msgType, bodyLen };
+	static long long lastTotal = 0;
 
-	if (!sendAll(sock, (char*)&header, sizeof(header)))
-		return false;
+	const FBackpressureStats& stats = gNetwork->GetBackpressureStats();
+	long long total = stats.conflatedFrames + stats.droppedStateFrames + stats.slowConsumerEvictions + stats.hardLimitEvictions;
 
-	if (body && bodyLen > 0)
-		return sendAll(sock, (char*)body, bodyLen);
+	if (total == lastTotal)
+		return;
 
-	return true;
+	lastTotal = total;
+
+	std::cout << "[Server] backpressure: conflated " << stats.conflatedFrames
+		<< ", dropped state " << stats.droppedStateFrames
+		<< " (" << stats.droppedStateBytes << " bytes)"
+		<< ", slow consumer kick " << stats.slowConsumerEvictions
+		<< ", hard limit kick " << stats.hardLimitEvictions << "\n";
 }
 
-void broadcast(int senderId, int msgType, const void* data, int len)
+// 이 샤드의 방에 넣음. 못 들어가면 이유를 보내고 원래 있던 곳에 그대로 둠.
+void JoinLocalRoom(Client* client, CRoom* room)
 {
-	for (auto& c : gClients)
-		sendMessage(c->sock, senderId, msgType, data, len);
+	CRoomManager* rooms = CShard::GetCurrent()->GetRoomManager();
+
+	if (!room)
+		rooms->SendReject(client, "Room not found.");
+	else if (room == client->room)
+		return;
+	else if (!room->IsJoinable())
+		rooms->SendReject(client, room->IsFull() ? "Room is full." : "Game in progress.");
+	else
+		rooms->JoinRoom(client, room);
 }
 
-void checkGameOver()
+// 다른 샤드에서 넘어온 클라를 받음. 넘어오기 전에 원래 방에서는 빠져 있음.
+// 공개된 목록은 조금 늦을 수 있어서 와보니 못 들어가는 경우도 있음. 빠른 입장이면 여기서 새로 만듦.
+// 오는 사이에 방이 밸런서로 옮겨갔어도 따라가지 않음. 옮겨지는 방은 게임중이라 어차피 못 들어가고,
+// 아직 HandoffDone 을 기다리는 연결을 또 넘기면 순서를 지킬 수 없음.
+void AdoptClient(Client* client, int roomId, bool isQuickJoin)
 {
-	int aliveCount = 0;
+	CRoomManager* rooms = CShard::GetCurrent()->GetRoomManager();
+	CRoom* room = rooms->FindRoom(roomId);
 
-	for (auto& c : gClients)
+	if (isQuickJoin && (!room || !room->IsJoinable()))
 	{
-		if (c->isAlive)
-			aliveCount++;
-	}
+		room = rooms->FindJoinableRoom();
 
-	if (aliveCount == 0)
-	{
-		for (auto& c : gClients)
+		if (!room)
+			room = rooms->CreateRoom();
+
+		if (!room)
 		{
-			auto _statInfo = CDataStorageManager::GetInst()->GetCharacterState(c->characterId);
-			c->InitStat(_statInfo);
-			c->Init();
+			rooms->SendReject(client, "No room available.");
+			return;
 		}
-		gMapId = 0;
-		gState = WAITING;
-		const char* msg = "All players dead. Game over.";
-		broadcast(0, (int)ServerMessage::MSG_GAME_OVER, msg, strlen(msg) + 1);
 	}
+
+	JoinLocalRoom(client, room);
 }
 
-void sendRoomFullInfo(Client* client)
+// 방이 다른 샤드에 있으면 클라째로 그 샤드에 넘김.
+// 넘긴 뒤로는 이 샤드에서 client 를 건드리면 안 됨.
+void MoveClientToShard(Client* client, int shardIndex, int roomId, bool isQuickJoin)
 {
-	int playerCount = (int)gClients.size();
-	int totalSize = sizeof(int)  // roomOwner
-		+ sizeof(int) // mapId
-		+ sizeof(int) // playerCount
-		+ playerCount // 인원수 곱
-		* (sizeof(int) // id
-			+ sizeof(bool)  // ready
-			+ sizeof(int)  // character
-			+ sizeof(int) * 3); // item*3
+	CShard::GetCurrent()->GetRoomManager()->LeaveRoom(client);
+
+	Connection* conn = client->conn;
+	CShard* target = CShardManager::GetInst()->GetShard(shardIndex);
+
+	// 받는 쪽 큐에 Adopt 가 먼저 들어가야 뒤따르는 메시지가 방에 들어간 다음에 처리됨.
+	// 이 샤드 큐에 남아있던 메시지는 CShardManager::Dispatch 가 따라 보내고,
+	// 받는 샤드는 HandoffDone 이 올때까지 바로 온 메시지를 쌓아둬서 순서가 섞이지 않음.
+	FShardCommand command;
+	command.type = EShardCommand::AdoptClient;
+	command.target = client;
+	command.arg0 = roomId;
+	command.arg1 = isQuickJoin ? 1 : 0;
+	target->Post(command);
+
+	CShard::GetCurrent()->HandOff(conn, target);
+}
 
-	std::vector<char> buffer(totalSize);
+// 이 샤드의 대기 방, 다른 샤드의 대기 방, 새 방 순서로 찾아서 넣음.
+void QuickJoin(Client* client)
+{
+	CShard* shard = CShard::GetCurrent();
+	CRoomManager* rooms = shard->GetRoomManager();
 
-	char* ptr = buffer.data();
+	CRoom* room = rooms->FindJoinableRoom();
+	if (room)
+	{
+		JoinLocalRoom(client, room);
+		return;
+	}
 
-	memcpy(ptr, &gRoomOwner, sizeof(int)); ptr += sizeof(int);
-	memcpy(ptr, &gMapId, sizeof(int)); ptr += sizeof(int);
-	memcpy(ptr, &playerCount, sizeof(int)); ptr += sizeof(int);
+	std::vector<RoomSummary> otherRooms;
+	CShardManager::GetInst()->CollectRoomList(otherRooms, shard->GetIndex());
 
-	for (auto& c : gClients)
+	for (auto& summary : otherRooms)
 	{
-		memcpy(ptr, &c->id, sizeof(int)); ptr += sizeof(int);
-		memcpy(ptr, &c->isReady, sizeof(bool)); ptr += sizeof(bool);
-		memcpy(ptr, &c->characterId, sizeof(int)); ptr += sizeof(int);
-		memcpy(ptr, c->itemSlots, sizeof(int) * 3); ptr += sizeof(int) * 3;
+		if (summary.state != WAITING || summary.playerCount >= summary.maxPlayers)
+			continue;
+
+		int shardIndex = CShardManager::GetInst()->FindRoomShard(summary.roomId);
+		if (shardIndex < 0 || shardIndex == shard->GetIndex())
+			continue;
+
+		MoveClientToShard(client, shardIndex, summary.roomId, true);
+		return;
 	}
 
-	sendMessage(client->sock, 0, (int)ServerMessage::MSG_ROOM_FULL_INFO, buffer.data(), totalSize);
+	room = rooms->CreateRoom();
+	if (room)
+		JoinLocalRoom(client, room);
+	else
+		rooms->SendReject(client, "No room available.");
 }
 
-bool recvAll(SOCKET sock, char* buffer, int len)
+// 로비 메시지. 방 밖에서도 처리함.
+void OnRoomList(Client* client, const MessageHeader& header, const char* body)
 {
-	int recvd = 0;
+	CShard::GetCurrent()->GetRoomManager()->SendRoomList(client);
+}
 
-	while (recvd < len)
-	{
-		int r = recv(sock, buffer + recvd, len - recvd, 0);
+void OnCreateRoom(Client* client, const MessageHeader& header, const char* body)
+{
+	CRoomManager* rooms = CShard::GetCurrent()->GetRoomManager();
 
-		if (r <= 0)
-			return false;
+	// 원래 방을 먼저 비워야 마지막 자리도 새 방으로 돌려쓸 수 있음.
+	rooms->LeaveRoom(client);
 
-		recvd += r;
-	}
-	return true;
+	CRoom* room = rooms->CreateRoom();
+	if (room)
+		rooms->JoinRoom(client, room);
+	else
+		rooms->SendReject(client, "No more rooms.");
 }
 
-bool receiveMessage(SOCKET sock, MessageHeader& header, std::vector<char>& body)
+void OnJoinRoom(Client* client, const MessageHeader& header, const char* body)
 {
-	if (!recvAll(sock, (char*)&header, sizeof(header)))
-		return false;
+	CShard* shard = CShard::GetCurrent();
+	CRoomManager* rooms = shard->GetRoomManager();
 
-	body.resize(header.bodyLen);
+	// 바디가 없으면 빠른 입장.
+	int roomId = 0;
+	DecodeBody<TClientSchema<ClientMessage::MSG_JOIN_ROOM>>(body, header.bodyLen, roomId);
 
-	if (header.bodyLen > 0)
-		return recvAll(sock, body.data(), header.bodyLen);
+	if (roomId <= 0)
+	{
+		QuickJoin(client);
+		return;
+	}
 
-	return true;
+	int shardIndex = CShardManager::GetInst()->FindRoomShard(roomId);
+
+	if (shardIndex < 0)
+		rooms->SendReject(client, "Room not found.");
+	else if (shardIndex == shard->GetIndex())
+		JoinLocalRoom(client, rooms->FindRoom(roomId));
+	else
+		MoveClientToShard(client, shardIndex, roomId, false);
 }
 
-void InGameUpdateLoop()
+void OnLeaveRoom(Client* client, const MessageHeader& header, const char* body)
 {
-	InitTimer();
+	if (!client->room)
+		return;
 
-	const float targetDelta = 1.0f / 30.0f;
-	float broadcastAccumulated = 0.0f;
+	CShard::GetCurrent()->GetRoomManager()->LeaveRoom(client);
+	CMessageSender::GetInst()->Send(client->conn, 0, (int)ServerMessage::MSG_ROOM_LEFT, nullptr, 0);
+}
 
-	const float countDownTime = 5.0f;
-	float curCountDownTime = 0.0f;
+// 연결 메시지.
+void OnHeartbeat(Client* client, const MessageHeader& header, const char* body)
+{
+	CMessageSender::GetInst()->Send(client->conn, client->id, (int)ServerMessage::MSG_HEARTBEAT_ACK, nullptr, 0);
+}
 
-	bool isFinishCountDown = false;
+// 수신 쪽은 I/O 스레드가 HELLO 를 자르면서 이미 바꿨음. 송신은 이 응답 뒤로 바뀜.
+void OnProtocolHello(Client* client, const MessageHeader& header, const char* body)
+{
+	int version;
+	DecodeBody<TClientSchema<ClientMessage::MSG_PROTOCOL_HELLO>>(body, header.bodyLen, version);
+	version = clamp(version, PROTOCOL_VERSION_V1, PROTOCOL_VERSION_MAX);
+	client->protocolVersion = version;
+	CMessageSender::GetInst()->Send(client->conn, MakeProtocolAckFrame(version));
+}
 
-	while (true)
-	{
-		Sleep(1);
-		std::lock_guard<std::recursive_mutex> lock(gMutex);
-		float dt = UpdateTimer(); // 이번 프레임 시간
+// 나머지는 방 안에서만 의미 있음.
+template<void (CRoom::*Handler)(Client*, const MessageHeader&, const char*)>
+void OnRoomMessage(Client* client, const MessageHeader& header, const char* body)
+{
+	if (client->room)
+		(client->room->*Handler)(client, header, body);
+}
 
-		if (gState != RUNNING)
-		{
-			isFinishCountDown = false;
-			continue;
-		}
+typedef void(*FClientHandler)(Client* client, const MessageHeader& header, const char* body);
 
-		broadcastAccumulated += dt;
+// 클라 메시지마다 처리 함수를 하나씩 정함. 빠뜨리면 처리 표를 만들때 컴파일이 안 됨.
+template<int Msg> struct TClientRoute;
 
-		// 카운트다운 처리
-		if (!isFinishCountDown)
-		{
-			curCountDownTime += dt;
-
-			//std::cout
-			//	<< " curCountDownTime " << curCountDownTime
-			//	<< "\n";
-
-			if (curCountDownTime < countDownTime)
-				continue;
-			else
-			{
-				isFinishCountDown = true;
-				curCountDownTime = 0.0f;
-				broadcast(0, (int)ServerMessage::MSG_COUNTDOWN_FINISHED, nullptr, 0);
-			}
-		}
+#define ROUTE_CLIENT_MESSAGE(Msg, Handler) \
+	template<> struct TClientRoute<ClientMessage::Msg> \
+	{ \
+		static void Handle(Client* client, const MessageHeader& header, const char* body) { Handler(client, header, body); } \
+	}
 
-		// 🧠 스탯 업데이트는 매 프레임 처리
-		for (auto& c : gClients)
-		{
-			if (!c->isAlive) continue;
-
-			if (c->GetIsProtection())
-			{
-				c->ReleaseProtection(dt);
-			}
-
-			if (c->GetIsStun())
-			{
-				c->ReleaseStun(dt);
-			}
-
-			//std::cout << "client_" << c->id
-			//	<< " c->GetIsStun(): " << c->GetIsStun() << "\n";
-
-			if (!c->GetIsStun())
-			{
-				float _height = c->GetDex() * dt * (c->isMovingUp ? 1.0f : -1.0f);
-				c->height += _height;
-				c->height = clamp(c->height, SCREEN_HEIGHT * -0.5f, SCREEN_HEIGHT * 0.5f);
-
-				//std::cout << "client_" << c->id
-				//	<< " c->isMovingUp: " << c->isMovingUp
-				//	<< " c->GetDex(): " << c->GetDex()
-				//	<< " dt: " << dt
-				//	<< " _height: " << _height
-				//	<< " c->height: " << c->height << "\n";
-
-				// 거리 & HP 갱신
-				float speed = c->GetSpeed();
-				float boostMultiplyValue = c->GetBoostValue();
-				float speedPerFrame = speed * dt * 0.01f * boostMultiplyValue;
-				c->AddPlayDistance(speedPerFrame);
-			}
-
-			if (!c->GetIsStun() && !c->GetIsProtection())
-			{
-#ifdef _DEBUG
-				c->DamagedPerDistance(dt * 10.0f);
-#else
-				c->DamagedPerDistance(dt);
-#endif
-				if (c->isAlive && c->GetCurHP() <= 0.0f)
-				{
-					std::cout << "DamagedPerDistance Dead id: " << c->id << "\n";
-					c->isAlive = false;
-					gDeadPlayers.insert(c->id);
-					broadcast(c->id, (int)ServerMessage::MSG_PLAYER_DEAD, nullptr, 0);
-					checkGameOver();
-				}
-			}
-		}
+ROUTE_CLIENT_MESSAGE(MSG_HEARTBEAT, OnHeartbeat);
+ROUTE_CLIENT_MESSAGE(MSG_START, OnRoomMessage<&CRoom::OnStart>);
+ROUTE_CLIENT_MESSAGE(MSG_PICK_CHARACTER, OnRoomMessage<&CRoom::OnPickCharacter>);
+ROUTE_CLIENT_MESSAGE(MSG_PICK_ITEM, OnRoomMessage<&CRoom::OnPickItem>);
+ROUTE_CLIENT_MESSAGE(MSG_PICK_MAP, OnRoomMessage<&CRoom::OnPickMap>);
+ROUTE_CLIENT_MESSAGE(MSG_READY, OnRoomMessage<&CRoom::OnReady>);
+ROUTE_CLIENT_MESSAGE(MSG_UNREADY, OnRoomMessage<&CRoom::OnUnready>);
+ROUTE_CLIENT_MESSAGE(MSG_MOVE_UP, OnRoomMessage<&CRoom::OnMoveUp>);
+ROUTE_CLIENT_MESSAGE(MSG_MOVE_DOWN, OnRoomMessage<&CRoom::OnMoveDown>);
+ROUTE_CLIENT_MESSAGE(MSG_TAKE_DAMAGE, OnRoomMessage<&CRoom::OnTakeDamage>);
+ROUTE_CLIENT_MESSAGE(MSG_BOOST_ON, OnRoomMessage<&CRoom::OnBoostOn>);
+ROUTE_CLIENT_MESSAGE(MSG_BOOST_OFF, OnRoomMessage<&CRoom::OnBoostOff>);
+ROUTE_CLIENT_MESSAGE(MSG_ROOM_LIST, OnRoomList);
+ROUTE_CLIENT_MESSAGE(MSG_CREATE_ROOM, OnCreateRoom);
+ROUTE_CLIENT_MESSAGE(MSG_JOIN_ROOM, OnJoinRoom);
+ROUTE_CLIENT_MESSAGE(MSG_LEAVE_ROOM, OnLeaveRoom);
+ROUTE_CLIENT_MESSAGE(MSG_PROTOCOL_HELLO, OnProtocolHello);
+
+// 연결 담당 샤드 스레드에서 돎.
+void HandleClientMessage(Connection* conn, const MessageHeader& header, const char* body)
+{
+	static const std::array<FClientHandler, ClientMessage::MSG_END> handlers =
+		MakeHandlerTable<TClientSchema, TClientRoute, FClientHandler>(std::make_index_sequence<ClientMessage::MSG_END>());
 
-		for (auto& c : gClients)
-		{
-			if (!c->isAlive)
-				continue;
-
-			int currentStep = static_cast<int>(c->GetPlayDistance() / 16.0f);
-			//std::cout << "client_" << c->id
-			//	<< " c->lastObstacleStep: " << c->lastObstacleStep
-			//	<< " currentStep: " << currentStep << "\n";
-
-			if (currentStep > c->lastObstacleStep)
-			{
-				c->lastObstacleStep = currentStep;
-
-				Obstacle obs;
-
-				if (gObstaclesByStep.count(currentStep))
-				{
-					obs = gObstaclesByStep[currentStep];
-				}
-				else
-				{
-					obs.scale = rand() % 50 + 100.0f;
-					obs.rotation = rand() % 360;
-					obs.height = (rand() % (int)SCREEN_HEIGHT) - (SCREEN_HEIGHT * 0.5f);
-					gObstaclesByStep.emplace(std::make_pair(currentStep, obs));
-				}
-
-				//std::cout << "client_" << c->id
-				//	<< " scale: " << obs.scale
-				//	<< " rotation: " << obs.rotation
-				//	<< " scheightale: " << obs.height << "\n";
-
-				// 다보낼 필요 없음.
-				sendMessage(c->sock, c->id, ServerMessage::MSG_OBSTACLE, &obs, sizeof(obs));
-			}
-		}
+	Client* client = conn->client;
 
-		// 60FPS 기준으로 메시지 브로드캐스트
-		while (broadcastAccumulated >= targetDelta)
-		{
-			broadcastAccumulated -= targetDelta;
-
-			for (auto& c : gClients)
-			{
-				//if (!c->isAlive) continue;
-
-				// 죽은 캐릭이라도 계속 보내야 함.
-				float _dist = c->GetPlayDistance();
-				float _height = c->height;
-				float _curHp = c->GetCurHP();
-
-				//std::cout << "client_" << c->id
-				//	<< " _dist: " << _dist
-				//	<< " _height: " << _height
-				//	<< " _curHp: " << _curHp << "\n";
-
-				if (gState == RUNNING)
-				{
-					broadcast(c->id, (int)ServerMessage::MSG_PLAYER_DISTANCE, &_dist, sizeof(float));
-					broadcast(c->id, (int)ServerMessage::MSG_PLAYER_HEIGHT, &_height, sizeof(float));
-					broadcast(c->id, (int)ServerMessage::MSG_TAKEN_DAMAGE, &_curHp, sizeof(float));
-				}
-			}
-		}
+	// 정리가 끝난 뒤에 도착한 메시지.
+	if (!client)
+		return;
+
+	// UDP 로 온 입력은 순서가 바뀔 수 있어서 더 새로운 번호만 받음.
+	if (client->protocolVersion >= PROTOCOL_VERSION_V4 && IsSnapshotAckCarrier(header.msgType) && header.bodyLen == (int)sizeof(SnapshotAck))
+	{
+		SnapshotAck ack;
+		memcpy(&ack, body, sizeof(ack));
+
+		if (client->snapshotAck == 0 || (int)(ack.seq - client->snapshotAck) > 0)
+			client->snapshotAck = ack.seq;
 	}
+
+	// 번호는 OnClientMessage 에서 스키마로 확인했음.
+	handlers[header.msgType](client, header, body);
 }
 
+// I/O 스레드나 UDP 채널 스레드에서 메시지 하나가 완성될때마다 호출됨.
+// body 는 수신 버퍼 안을 가리키고 있어서 명령에 복사해서 담당 샤드로 넘김.
+void OnClientMessage(Connection* conn, const MessageHeader& header, const char* body)
+{
+	// 모르는 메시지나 스키마와 길이가 다른 바디는 샤드까지 안 보냄.
+	// 그래서 샤드 쪽 처리에서는 바디 길이를 다시 안 봄.
+	if (header.bodyLen > SHARD_COMMAND_BODY_MAX || !IsValidClientBody(header.msgType, body, header.bodyLen))
+		return;
+
+	FShardCommand command;
+	command.type = EShardCommand::ClientMessage;
+	command.header = header;
+	if (header.bodyLen > 0)
+		memcpy(command.body, body, header.bodyLen);
 
+	CShardManager::GetInst()->Post(conn, command);
+}
 
-void clientThread(Client* client)
+// 연결 담당 샤드 스레드에서 돎.
+void HandleDisconnect(Connection* conn)
 {
-	while (true)
-	{
-		MessageHeader header;
-		std::vector<char> body;
+	Client* client = conn->client;
 
-		if (!receiveMessage(client->sock, header, body))
-			break;
+	CUdpChannel::GetInst()->RemoveSession(conn);
+	CShard::GetCurrent()->GetRoomManager()->LeaveRoom(client);
 
-		std::lock_guard<std::recursive_mutex> lock(gMutex);
+	conn->client = nullptr;
+	delete client;
 
-		switch ((ClientMessage::Type)header.msgType)
-		{
-		case ClientMessage::MSG_HEARTBEAT:
-			sendMessage(client->sock, client->id, (int)ServerMessage::MSG_HEARTBEAT_ACK, nullptr, 0);
-			break;
-
-		case ClientMessage::MSG_START:
-			if (client->id == gRoomOwner)
-			{
-				bool allReady = std::all_of(gClients.begin(), gClients.end(),
-					[](Client* c)
-					{
-						return (c->id == gRoomOwner) || c->isReady;
-					});
-
-				if (allReady)
-				{
-					gState = RUNNING;
-					gObstaclesByStep.clear();
-					gDeadPlayers.clear();
-					for (auto& c : gClients)
-					{
-						c->isAlive = true;
-
-						// 스탯 계산해서 Init 하기.
-						// 테이블 읽어서 기본 스텟 초기화.
-						auto _statInfo = CDataStorageManager::GetInst()->GetCharacterState(c->characterId);
-
-						std::cout << "client_" << c->id
-							<< " _statInfo.HP: " << _statInfo.HP
-							<< " _statInfo.Speed: " << _statInfo.Speed
-							<< " _statInfo.Dex: " << _statInfo.Dex
-							<< " _statInfo.Def: " << _statInfo.Def
-							<< "\n";
-
-						c->InitStat(_statInfo);
-
-						std::cout << "client_" << c->id
-							<< " c->GetHP: " << c->GetCurHP()
-							<< " c->GetSpeed: " << c->GetSpeed()
-							<< " c->GetDex: " << c->GetDex()
-							<< " c->GetDef: " << c->GetDef()
-							<< "\n";
-
-						// 착용한 아이템 스텟에 적용.
-						auto _itemDatas = CDataStorageManager::GetInst()->GetItemInfoDatas();
-						int _itemLength = sizeof(c->itemSlots) / sizeof(c->itemSlots[0]);
-						for (int i = 0; i < _itemLength; i++)
-						{
-							int _itemIndexInSlot = c->itemSlots[i];
-							if (_itemIndexInSlot >= 0)
-							{
-								// 어떤 스탯에 얼마를 적용할것인지.
-								c->AddValueByStatIndex(
-									static_cast<EStatInfo::Type>(_itemDatas[_itemIndexInSlot].StatType)
-									, _itemDatas[_itemIndexInSlot].AddValue);
-							}
-						}
-					}
-
-				}
-
-				// 시작에 대한 결과를 알려줘야 함.
-				int readyFlag = static_cast<int>(allReady);
-				broadcast(client->id, (int)ServerMessage::MSG_START_ACK, &readyFlag, sizeof(int));
-			}
-			break;
-
-		case ClientMessage::MSG_READY:
-			client->isReady = true;
-			broadcast(client->id, (int)ServerMessage::MSG_READY, nullptr, 0);
-			break;
-
-		case ClientMessage::MSG_UNREADY:
-			client->isReady = false;
-			broadcast(client->id, (int)ServerMessage::MSG_UNREADY, nullptr, 0);
-			break;
-
-		case ClientMessage::MSG_PICK_CHARACTER:
-			if (header.bodyLen == sizeof(int))
-			{
-				memcpy(&client->characterId, body.data(), sizeof(int));
-				broadcast(client->id, (int)ServerMessage::MSG_PICK_CHARACTER, body.data(), sizeof(int));
-			}
-			break;
-
-		case ClientMessage::MSG_PICK_ITEM:
-			if (header.bodyLen == sizeof(int) * 2)
-			{
-				int slot, itemId;
-				memcpy(&slot, body.data(), sizeof(int));
-				memcpy(&itemId, body.data() + sizeof(int), sizeof(int));
-				if (slot >= 0 && slot < 3) client->itemSlots[slot] = itemId;
-				broadcast(client->id, (int)ServerMessage::MSG_PICK_ITEM, body.data(), sizeof(int) * 2);
-			}
-			break;
-
-		case ClientMessage::MSG_PICK_MAP:
-			if (client->id == gRoomOwner && header.bodyLen == sizeof(int))
-			{
-				memcpy(&gMapId, body.data(), sizeof(int));
-				CDataStorageManager::GetInst()->SetSelectedMapIndex(gMapId);
-				broadcast(0, (int)ServerMessage::MSG_PICK_MAP, &gMapId, sizeof(int));
-			}
-			break;
-
-		case ClientMessage::MSG_MOVE_UP:
-			client->isMovingUp = true;
-			broadcast(client->id, (int)ServerMessage::MSG_MOVE_UP, nullptr, 0);
-			//std::cout << "ClientMessage::MSG_MOVE_UP id: " << client->id << "\n";
-			break;
-
-		case ClientMessage::MSG_MOVE_DOWN:
-			client->isMovingUp = false;
-			broadcast(client->id, (int)ServerMessage::MSG_MOVE_DOWN, nullptr, 0);
-			//std::cout << "ClientMessage::MSG_MOVE_DOWN id: " << client->id << "\n";
-			break;
-
-		case ClientMessage::MSG_TAKE_DAMAGE:
-			if (header.bodyLen == sizeof(float))
-			{
-				std::cout << "ClientMessage::MSG_TAKE_DAMAGE id: " << client->id << "\n";
-				// 맵 테이블에 의한 데이지.
-				float _damage = CDataStorageManager::GetInst()->GetSelectedMapInfo().CollisionDamage;
-				client->SetStun();
-				broadcast(client->id, (int)ServerMessage::MSG_TAKEN_STUN, nullptr, 0);
-				client->Damaged(_damage);
-
-				struct { int id; float hp; } packetHp{ client->id, client->GetCurHP() };
-				broadcast(client->id, (int)ServerMessage::MSG_TAKEN_DAMAGE, &packetHp, sizeof(packetHp));
-
-				if (client->isAlive && client->GetCurHP() <= 0.0f)
-				{
-					std::cout << "ClientMessage::MSG_TAKE_DAMAGE Dead######## id: " << client->id << "\n";
-					client->isAlive = false;
-					gDeadPlayers.insert(client->id);
-					broadcast(client->id, (int)ServerMessage::MSG_PLAYER_DEAD, nullptr, 0);
-					checkGameOver();
-				}
-			}
-			break;
-
-		case ClientMessage::MSG_BOOST_ON:
-			client->SetIsBoostMode(true);
-			broadcast(client->id, (int)ServerMessage::MSG_BOOST_ON, nullptr, 0);
-			break;
-
-		case ClientMessage::MSG_BOOST_OFF:
-			client->SetIsBoostMode(false);
-			broadcast(client->id, (int)ServerMessage::MSG_BOOST_OFF, nullptr, 0);
-			break;
-
-		default:
-			break;
-		}
-	}
+	gClientCount--;
 
-	{
-		std::lock_guard<std::recursive_mutex> lock(gMutex);
-		auto it = std::find_if(gClients.begin(), gClients.end()
-			, [client](Client* c)
-			{
-				return c->id == client->id;
-			});
-
-		if (it != gClients.end())
-		{
-			bool wasOwner = (client->id == gRoomOwner);
-			gClients.erase(it);
-			broadcast(client->id, (int)ServerMessage::MSG_DISCONNECT, &client->id, sizeof(int));
-
-			if (gClients.empty())
-				gRoomOwner = -1;
-			else if (wasOwner)
-			{
-				gRoomOwner = gClients.front()->id;
-				broadcast(0, (int)ServerMessage::MSG_NEW_OWNER, &gRoomOwner, sizeof(int));
-			}
-		}
-	}
+	// 접속때 잡아둔 게임 쪽 참조.
+	conn->Release();
+}
 
-	closesocket(client->sock);
-	delete client;
+// 소켓은 백엔드가 닫음. 게임 쪽 정리는 담당 샤드에서.
+void OnClientDisconnect(Connection* conn)
+{
+	FShardCommand command;
+	command.type = EShardCommand::ClientDisconnected;
+	CShardManager::GetInst()->Post(conn, command);
 }
 
 void LoadGameData()
@@ -692,19 +378,229 @@ void LoadGameData()
 	std::string itemResult = CCURL::GetInst()->SendRequest(path, METHOD_GET);
 	printf(("itemResult: " + itemResult).c_str());
 	CDataStorageManager::GetInst()->SetItemInfoData(itemResult);
+
+	// 충돌 판정용으로 맵 라인 노드를 펴둠.
+	CCollisionManager::GetInst()->Build();
+}
+
+// 처음 맡은 샤드 스레드에서 돎.
+// 예전 클라는 로비를 몰라서 접속하면 바로 대기중인 방에 넣어줌.
+void AddNewClient(Connection* conn)
+{
+	Client* c = new Client;
+	c->id = gNextId++;
+	c->Init();
+
+	conn->client = c;
+	c->conn = conn;
+
+	std::cout << "[Server] new client " << c->id << " on shard " << conn->shardIndex << "\n";
+
+	CMessageSender::GetInst()->Send<TServerSchema<ServerMessage::MSG_CONNECTED>>(c->conn, c->id, c->id);
+
+	// 새 클라만 알아듣고 HELLO 로 답함. 예전 클라는 모르는 메시지라 무시하고 v1 로 계속 씀.
+	CMessageSender::GetInst()->Send<TServerSchema<ServerMessage::MSG_PROTOCOL_OFFER>>(c->conn, 0, PROTOCOL_VERSION_MAX);
+
+	if (CUdpChannel::GetInst()->IsEnabled())
+	{
+		UdpOffer offer{ CUdpChannel::GetInst()->GetPort(), CUdpChannel::GetInst()->CreateSession(conn) };
+		CMessageSender::GetInst()->Send<TServerSchema<ServerMessage::MSG_UDP_OFFER>>(c->conn, c->id, offer);
+	}
+
+	QuickJoin(c);
+}
+
+// 샤드 스레드에서 명령 하나마다 호출됨. 연결 명령은 담당 샤드에서만 옴.
+void OnShardCommand(const FShardCommand& command)
+{
+	switch (command.type)
+	{
+	case EShardCommand::ClientConnected:
+		AddNewClient(command.conn);
+		break;
+
+	case EShardCommand::ClientMessage:
+		HandleClientMessage(command.conn, command.header, command.body);
+		break;
+
+	case EShardCommand::ClientDisconnected:
+		HandleDisconnect(command.conn);
+		break;
+
+	case EShardCommand::AdoptClient:
+		AdoptClient((Client*)command.target, command.arg0, command.arg1 != 0);
+		break;
+
+	default:
+		break;
+	}
 }
 
-int main()
+// 백엔드가 새 연결을 받을때마다 I/O 스레드에서 호출됨.
+void OnClientAccept(SOCKET clientSock)
 {
-	srand(GetTickCount());
-	rand();
+	if (gClientCount++ >= MAX_CONNECTIONS)
+	{
+		gClientCount--;
+
+		const char* msg = "Server is full.";
+		MessageHeader header{ 0, (int)ServerMessage::MSG_CONNECTED_REJECT, (int)strlen(msg) + 1 };
+		sendAll(clientSock, (char*)&header, sizeof(header));
+		sendAll(clientSock, msg, header.bodyLen);
+		closesocket(clientSock);
+		return;
+	}
+
+	Connection* conn = new Connection;
+	conn->sock = clientSock;
+	conn->shardIndex = CShardManager::GetInst()->PickHomeShard();
+
+	// 게임 쪽 참조. HandleDisconnect 에서 놓음.
+	conn->AddRef();
+
+	// 수신을 걸기 전에 넣어야 첫 메시지보다 먼저 처리됨.
+	FShardCommand command;
+	command.type = EShardCommand::ClientConnected;
+	CShardManager::GetInst()->Post(conn, command);
+
+	gNetwork->AddConnection(conn);
+}
+
+// 느린 클라 대응 옵션. 안 주면 Backpressure.h 의 기본값.
+// --send-high-water <bytes> --send-hard-limit <bytes> --slow-consumer-ms <ms> --no-drop-state
+FBackpressurePolicy ParseBackpressurePolicy(int argc, char* argv[])
+{
+	FBackpressurePolicy policy;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = (i + 1 < argc);
+
+		if (strcmp(argv[i], "--send-high-water") == 0 && hasValue)
+			policy.highWaterBytes = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--send-hard-limit") == 0 && hasValue)
+			policy.hardLimitBytes = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--slow-consumer-ms") == 0 && hasValue)
+			policy.slowConsumerTimeoutMs = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--no-drop-state") == 0)
+			policy.dropStateUpdates = false;
+	}
+
+	if (policy.hardLimitBytes < policy.highWaterBytes)
+		policy.hardLimitBytes = policy.highWaterBytes;
+
+	std::cout << "[Server] send high-water " << policy.highWaterBytes
+		<< " / hard limit " << policy.hardLimitBytes
+		<< " / slow consumer " << policy.slowConsumerTimeoutMs << "ms"
+		<< (policy.dropStateUpdates ? "" : " / keep state updates") << "\n";
+
+	return policy;
+}
+
+// --iocp 를 주면 IOCP 백엔드를 쓰고, 못 쓰는 환경이면 WSAPoll 리액터로 내려감.
+INetworkBackend* SelectNetworkBackend(int argc, char* argv[])
+{
+	bool useIocp = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--iocp") == 0)
+			useIocp = true;
+	}
+
+	FBackpressurePolicy policy = ParseBackpressurePolicy(argc, argv);
+	CIocpNetworkBackend::GetInst()->SetBackpressurePolicy(policy);
+	CNetworkReactor::GetInst()->SetBackpressurePolicy(policy);
+
+	if (useIocp)
+	{
+		if (CIocpNetworkBackend::GetInst()->Init(IO_THREAD_COUNT, OnClientMessage, OnClientDisconnect))
+			return CIocpNetworkBackend::GetInst();
+
+		std::cout << "[Server] IOCP backend unavailable. fallback to WSAPoll.\n";
+	}
+
+	if (CNetworkReactor::GetInst()->Init(IO_THREAD_COUNT, OnClientMessage, OnClientDisconnect))
+		return CNetworkReactor::GetInst();
+
+	return nullptr;
+}
+
+// --shards <n> 으로 게임 샤드 수를 정함. 안 주면 코어 수만큼.
+int ParseShardCount(int argc, char* argv[])
+{
+	int shardCount = (int)std::thread::hardware_concurrency();
+
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], "--shards") == 0)
+			shardCount = atoi(argv[++i]);
+	}
+
+	return shardCount > 0 ? shardCount : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	// 스냅샷 비트 형식이 되읽히는지. 어긋나면 클라가 엉뚱한 값을 받으니까 띄우지 않음.
+	if (!CheckSnapshotCodec())
+	{
+		std::cout << "[Server] Snapshot codec self check failed.\n";
+		return -1;
+	}
 
 	LoadGameData();
 
 	WSADATA wsa;
 	WSAStartup(MAKEWORD(2, 2), &wsa);
 
-	std::thread(InGameUpdateLoop).detach();
+	if (!CShardManager::GetInst()->Init(ParseShardCount(argc, argv), OnShardCommand))
+	{
+		std::cout << "[Server] Shard init failed.\n";
+		WSACleanup();
+		return -1;
+	}
+
+	gNetwork = SelectNetworkBackend(argc, argv);
+
+	if (!gNetwork)
+	{
+		std::cout << "[Server] Network backend init failed.\n";
+		WSACleanup();
+		return -1;
+	}
+
+	CMessageSender::GetInst()->Init(gNetwork);
+
+	// --no-udp 면 UDP 채널 없이 TCP 로만. 열기 실패해도 TCP 로만 감.
+	bool useUdp = true;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--no-udp") == 0)
+			useUdp = false;
+	}
+
+	if (useUdp && !CUdpChannel::GetInst()->Init(gNetwork, PORT, OnClientMessage))
+		std::cout << "[Server] UDP channel unavailable. TCP only.\n";
+
+	// --server-obstacles 면 시드를 숨기고 서버가 장애물을 묶어서 보냄.
+	// --dead-reckoning 이면 클라가 늘려서 구할 수 있는 높이/거리는 오차를 넘을때만 보냄.
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--server-obstacles") == 0)
+		{
+			CRoom::SetObstacleMode(EObstacleMode::ServerStreamed);
+			std::cout << "[Server] obstacles streamed by server.\n";
+		}
+		else if (strcmp(argv[i], "--dead-reckoning") == 0)
+		{
+			// 델타 스냅샷을 받는 v4 클라에게만 해당.
+			CRoom::SetDeadReckoning(true);
+			std::cout << "[Server] dead reckoning on.\n";
+		}
+	}
+
+	CShardManager::GetInst()->Start();
 
 	SOCKET server = socket(AF_INET, SOCK_STREAM, 0);
 	sockaddr_in addr{};
@@ -714,48 +610,34 @@ int main()
 	bind(server, (sockaddr*)&addr, sizeof(addr));
 	listen(server, SOMAXCONN);
 
-	std::cout << "[Server] Listening on port " << PORT << "...\n";
-
-	while (true)
+	if (!gNetwork->StartAccept(server, OnClientAccept))
 	{
-		sockaddr_in clientAddr{};
-		int size = sizeof(clientAddr);
-		SOCKET clientSock = accept(server, (sockaddr*)&clientAddr, &size);
-		std::lock_guard<std::recursive_mutex> lock(gMutex);
-
-		if ((int)gClients.size() >= MAX_PLAYERS)
-		{
-			const char* msg = "Room is full.";
-			sendMessage(clientSock, 0, (int)ServerMessage::MSG_CONNECTED_REJECT, msg, strlen(msg) + 1);
-			closesocket(clientSock);
-			continue;
-		}
-
-		Client* c = new Client;
-		c->sock = clientSock;
-		c->id = gNextId++;
-		gClients.push_back(c);
-		c->Init();
+		std::cout << "[Server] StartAccept failed.\n";
+		closesocket(server);
+		WSACleanup();
+		return -1;
+	}
 
-		std::cout << "[Server] gClients.push_back(c); " << c->id << "\n";
+	std::cout << "[Server] Listening on port " << PORT << " (" << gNetwork->GetName() << ")...\n";
 
-		if (gRoomOwner == -1)
-			gRoomOwner = c->id;
+	// 수신은 백엔드 스레드, 게임은 샤드 스레드가 맡으니 메인 스레드는 샤드 간 부하 조절과 통계만 맡음.
+	ULONGLONG lastReportTime = GetTickCount64();
 
-		sendMessage(clientSock, c->id, (int)ServerMessage::MSG_CONNECTED, &c->id, sizeof(int));
-		sendRoomFullInfo(c);
+	while (true)
+	{
+		Sleep(SHARD_BALANCE_INTERVAL_MS);
+		CShardManager::GetInst()->Balance();
 
-		for (auto& other : gClients)
-		{
-			if (other->id != c->id)
-				sendMessage(other->sock, c->id, (int)ServerMessage::MSG_JOIN, &c->id, sizeof(int));
-		}
+		ULONGLONG now = GetTickCount64();
+		if (now - lastReportTime < STATS_REPORT_INTERVAL_MS)
+			continue;
 
-		c->thread = std::thread(clientThread, c);
-		c->thread.detach();
+		lastReportTime = now;
+		ReportBackpressureStats();
+		CShardManager::GetInst()->ReportStats();
 	}
+
 	closesocket(server);
 	WSACleanup();
 	return 0;
 }
-